@@ -0,0 +1,90 @@
+// Throughput of the actor runtime: lookups, inserts and stabilization rounds over a
+// bootstrapped ring, for 1, 2, 4, ... worker threads, against plain Node::lookup.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/actor_bench.cpp
+//            src/actor_runtime.cpp src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o actor_bench
+// Run:   ./actor_bench [nodes] [ops] [max_threads]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "actor_runtime.h"
+#include "node.h"
+#include "ring.h"
+
+namespace {
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t opCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+    unsigned maxThreads = argc > 3 ? (unsigned)std::strtoul(argv[3], nullptr, 10)
+                                   : std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937_64 rng(1);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+
+    Ring ring;
+    ring.bootstrap(ids);
+
+    std::vector<NodeHandle> origins(opCount);
+    std::vector<NodeId> keys(opCount);
+    for (size_t i = 0; i < opCount; ++i) {
+        origins[i] = (NodeHandle)(rng() % ring.size());
+        keys[i] = (NodeId)rng();
+    }
+
+    std::cout << "nodes=" << ring.size() << " ops=" << opCount << " bits=" << BITLENGTH << "\n";
+
+    // Baseline: iterative lookups on the calling thread
+    auto start = std::chrono::steady_clock::now();
+    size_t hops = 0;
+    for (size_t i = 0; i < opCount; ++i) {
+        hops += ring.node(origins[i])->lookup(keys[i]).hops;
+    }
+    double base = seconds(start);
+    std::cout << "Node::lookup        " << opCount / base / 1e6 << " M/s  (mean hops "
+              << (double)hops / opCount << ")\n";
+
+    std::vector<LookupResult> results(opCount);
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        ActorRuntime runtime(ring, threads);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < opCount; ++i) {
+            runtime.lookup(ring.node(origins[i]), keys[i], &results[i]);
+        }
+        runtime.waitIdle();
+        double lookups = seconds(start);
+        uint64_t messages = runtime.messagesProcessed();
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < opCount; ++i) {
+            runtime.insert(ring.node(origins[i]), keys[i], Value(Blob(&keys[i], sizeof(keys[i]))));
+        }
+        runtime.waitIdle();
+        double inserts = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        runtime.stabilize();
+        runtime.waitIdle();
+        double round = seconds(start);
+
+        std::cout << "actors threads=" << threads
+                  << "  lookup " << opCount / lookups / 1e6 << " M/s"
+                  << "  insert " << opCount / inserts / 1e6 << " M/s"
+                  << "  messages " << messages / lookups / 1e6 << " M/s"
+                  << "  stabilize round " << round * 1e3 << " ms\n";
+    }
+    return 0;
+}
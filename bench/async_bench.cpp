@@ -0,0 +1,121 @@
+// Pipelined lookups: one client resolves random keys, first with the synchronous lookup loop
+// (as main.cpp does with find(), minus the printing), then through an AsyncScheduler with a
+// growing number of requests in flight. Each in-flight lookup prefetches the next node and
+// yields, so cache misses of different lookups overlap. Then the same for inserts. Async
+// answers are checked against the synchronous ones. Needs C++20 for the coroutines.
+//
+// Build: g++ -std=c++20 -O2 -DBITLENGTH=32 -DDHT_LOG_LEVEL=0 -Iinclude bench/async_bench.cpp
+//            src/async_lookup.cpp src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp
+//            src/log.cpp src/metrics.cpp src/node.cpp src/node_pool.cpp src/ring.cpp src/value.cpp -pthread
+//            -o async_bench
+// Run:   ./async_bench [nodes] [ops]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "async_lookup.h"
+#include "node.h"
+#include "ring.h"
+
+namespace {
+
+// Requests submitted per run(); their coroutine frames stay in cache
+const size_t kBatch = 4096;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string label, size_t ops, double time, size_t mismatches) {
+    label.resize(26, ' ');
+    std::cout << label << ops / time / 1e6 << " M ops/s  mismatches " << mismatches << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+    size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+    std::mt19937_64 rng(43);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+    Ring ring;
+    ring.bootstrap(ids);
+    Node* client = ring.node(0);
+
+    std::vector<NodeId> keys(ops);
+    for (NodeId& key : keys) key = (NodeId)rng();
+    std::cout << "nodes=" << ring.size() << " ops=" << ops << " bits=" << BITLENGTH << "\n";
+
+    // Synchronous baseline
+    std::vector<LookupResult> expected(ops);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) expected[i] = client->lookup(keys[i]);
+    report("lookup sync", ops, seconds(start), 0);
+
+    const size_t windows[] = {1, 4, 8, 16, 64, 4096};
+    for (size_t window : windows) {
+        AsyncScheduler scheduler(window);
+        std::vector<LookupResult> results(ops);
+        start = std::chrono::steady_clock::now();
+        for (size_t begin = 0; begin < ops; begin += kBatch) {
+            for (size_t i = begin; i < std::min(ops, begin + kBatch); ++i) {
+                scheduler.spawn(scheduler.lookup(client, keys[i]), [&results, i](LookupResult&& result) {
+                    results[i] = std::move(result);
+                });
+            }
+            scheduler.run();
+        }
+        double time = seconds(start);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < ops; ++i) {
+            mismatches += results[i].node != expected[i].node || results[i].hops != expected[i].hops;
+        }
+        report("lookup async window " + std::to_string(window), ops, time, mismatches);
+    }
+
+    // The same through futures (one shared state per request)
+    {
+        AsyncScheduler scheduler(16);
+        std::vector<std::future<LookupResult>> futures;
+        futures.reserve(ops);
+        start = std::chrono::steady_clock::now();
+        for (size_t begin = 0; begin < ops; begin += kBatch) {
+            for (size_t i = begin; i < std::min(ops, begin + kBatch); ++i) {
+                futures.push_back(scheduler.submitLookup(client, keys[i]));
+            }
+            scheduler.run();
+        }
+        double time = seconds(start);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < ops; ++i) mismatches += futures[i].get().node != expected[i].node;
+        report("lookup futures window 16", ops, time, mismatches);
+    }
+
+    // Inserts: the synchronous loop, then the scheduler
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) client->insert(keys[i], Value(Blob(&keys[i], sizeof(keys[i]))));
+    report("insert sync", ops, seconds(start), 0);
+
+    AsyncScheduler scheduler(16);
+    std::vector<Node*> stored(ops);
+    start = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < ops; begin += kBatch) {
+        for (size_t i = begin; i < std::min(ops, begin + kBatch); ++i) {
+            scheduler.spawn(scheduler.insert(client, keys[i], Value(Blob(&keys[i], sizeof(keys[i])))),
+                            [&stored, i](Node* node) { stored[i] = node; });
+        }
+        scheduler.run();
+    }
+    double time = seconds(start);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < ops; ++i) mismatches += stored[i] != expected[i].node;
+    report("insert async window 16", ops, time, mismatches);
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Location caches under a Zipf-skewed workload: lookups for hot keys issued from a set of
+// client nodes, for several cache capacities (0 = no cache). Reports mean hops, hit rate
+// and hops saved, then churns the ring (joins and leaves, re-stabilized) and reports how
+// many cached owners turned out stale. Every answer is checked against Node::lookup.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/cache_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o cache_bench
+// Run:   ./cache_bench [nodes] [ops] [clients] [zipf_s]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+#include "zipf.h"
+
+namespace {
+
+const size_t kDistinctKeys = 100000;
+
+struct Workload {
+    std::vector<Node*> origins;
+    std::vector<NodeId> keys;
+};
+
+Workload makeWorkload(const std::vector<Node*>& clients, const std::vector<NodeId>& keyIds,
+                      const Zipf& zipf, size_t ops, std::mt19937_64& rng) {
+    Workload w;
+    w.origins.resize(ops);
+    w.keys.resize(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        w.origins[i] = clients[rng() % clients.size()];
+        w.keys[i] = keyIds[zipf(rng)];
+    }
+    return w;
+}
+
+void runPhase(const char* label, const Workload& w, Ring& ring) {
+    LocationCacheStats before = ring.locationCacheStats();
+    size_t hops = 0;
+    size_t wrong = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < w.keys.size(); ++i) {
+        LookupResult result = w.origins[i]->cachedLookup(w.keys[i]);
+        hops += result.hops;
+        wrong += result.node != w.origins[i]->lookup(w.keys[i]).node;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    LocationCacheStats after = ring.locationCacheStats();
+    LocationCacheStats phase;
+    phase.hits = after.hits - before.hits;
+    phase.misses = after.misses - before.misses;
+    phase.stale = after.stale - before.stale;
+    phase.hopsSaved = after.hopsSaved - before.hopsSaved;
+
+    std::cout << label << "  mean hops " << (double)hops / w.keys.size()
+              << "  hit rate " << 100.0 * phase.hitRate() << "%"
+              << "  stale " << phase.stale
+              << "  hops saved " << phase.hopsSaved
+              << "  wrong " << wrong
+              << "  (" << seconds * 1e3 << " ms incl. check)\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500000;
+    size_t clientCount = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100;
+    double s = argc > 4 ? std::strtod(argv[4], nullptr) : 0.99;
+
+    std::mt19937_64 rng(5);
+    std::vector<NodeId> keyIds(kDistinctKeys);
+    for (NodeId& id : keyIds) id = (NodeId)rng();
+    Zipf zipf(kDistinctKeys, s);
+
+    std::cout << "nodes=" << nodeCount << " ops=" << ops << " clients=" << clientCount
+              << " zipf_s=" << s << " bits=" << BITLENGTH << "\n";
+
+    const size_t capacities[] = {0, 16, 64, 256, 1024};
+    for (size_t capacity : capacities) {
+        std::mt19937_64 ringRng(11);
+        std::vector<NodeId> ids(nodeCount);
+        for (NodeId& id : ids) id = (NodeId)ringRng();
+
+        Ring ring;
+        ring.bootstrap(ids);
+        ring.enableLocationCaches(capacity);
+
+        std::vector<Node*> active = ring.activeNodes();
+        std::vector<Node*> clients(active.begin(), active.begin() + std::min(clientCount, active.size()));
+        std::mt19937_64 opRng(13);
+
+        std::cout << "capacity " << capacity << "\n";
+        runPhase("  steady", makeWorkload(clients, keyIds, zipf, ops, opRng), ring);
+
+        // Churn: 5% of the (non-client) nodes leave, as many join, then the ring re-stabilizes
+        size_t churn = nodeCount / 20;
+        for (size_t i = 0; i < churn; ++i) {
+            Node* leaving = active[clients.size() + (size_t)(ringRng() % (active.size() - clients.size()))];
+            if (!leaving->isInRing()) continue;
+            leaving->leave();
+            leaving->repairFingersAfterLeave();
+        }
+        for (size_t i = 0; i < churn; ++i) {
+            Node* joining = ring.addNode((NodeId)ringRng());
+            joining->enableLocationCache(capacity);
+            joining->join(clients[0]);
+        }
+        ring.stabilizeNetwork();
+        ring.fixAllFingers();
+
+        runPhase("  churned", makeWorkload(clients, keyIds, zipf, ops, opRng), ring);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Lookups under churn: a bootstrapped ring loses a fraction of its nodes per epoch to
+// abrupt failures (Node::fail, no hand-over) with no repair pass in between. Lookups from
+// live nodes route around the failed fingers and successors; a lookup succeeds if it
+// returns the first live node at or after the key. Reports success rate, mean hops and
+// extra hops over the healthy ring, and failed entries skipped per lookup. After each
+// epoch every live node runs one local stabilize() to refresh its successor list.
+// Rebuild with -DSUCCESSOR_LIST_LENGTH=1 to compare against a plain successor pointer.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/churn_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp src/node_pool.cpp src/ring.cpp
+//            src/value.cpp -pthread -o churn_bench
+// Run:   ./churn_bench [nodes] [lookups] [fail_fraction_per_epoch] [epochs]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+
+namespace {
+
+struct EpochStats {
+    size_t succeeded = 0;
+    size_t unresolved = 0;   // Every known successor had failed
+    size_t hops = 0;
+    size_t timeouts = 0;
+};
+
+EpochStats runLookups(std::vector<Node*>& live, size_t lookupCount, std::mt19937_64& rng) {
+    std::vector<NodeId> ids(live.size());
+    for (size_t i = 0; i < live.size(); ++i) ids[i] = live[i]->getId();
+
+    EpochStats stats;
+    for (size_t i = 0; i < lookupCount; ++i) {
+        Node* origin = live[rng() % live.size()];
+        NodeId key = (NodeId)rng();
+        LookupResult result = origin->lookup(key);
+
+        size_t j = std::lower_bound(ids.begin(), ids.end(), key) - ids.begin();
+        Node* owner = live[j == ids.size() ? 0 : j];
+        if (!result.node) {
+            stats.unresolved++;
+            continue;
+        }
+        if (result.node == owner) stats.succeeded++;
+        stats.hops += result.hops;
+        stats.timeouts += result.timeouts;
+    }
+    return stats;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    size_t lookupCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    double failFraction = argc > 3 ? std::strtod(argv[3], nullptr) : 0.1;
+    int epochs = argc > 4 ? std::atoi(argv[4]) : 5;
+
+    std::mt19937_64 rng(3);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+
+    Ring ring;
+    ring.bootstrap(ids);
+    std::vector<Node*> live = ring.activeNodes();
+    std::sort(live.begin(), live.end(), [](Node* a, Node* b) { return a->getId() < b->getId(); });
+
+    EpochStats base = runLookups(live, lookupCount, rng);
+    double baseHops = (double)base.hops / lookupCount;
+    std::cout << "nodes=" << live.size() << " lookups=" << lookupCount << " bits=" << BITLENGTH
+              << " successor_list=" << SUCCESSOR_LIST_LENGTH << " fail_per_epoch=" << failFraction << "\n"
+              << "healthy  mean hops " << baseHops << "\n";
+
+    for (int epoch = 1; epoch <= epochs && live.size() > 1; ++epoch) {
+        // Abrupt failures: nobody is told, no keys or links are handed over
+        std::shuffle(live.begin(), live.end(), rng);
+        size_t failures = std::min(live.size() - 1, (size_t)(live.size() * failFraction));
+        for (size_t i = 0; i < failures; ++i) live[i]->fail();
+        live.erase(live.begin(), live.begin() + failures);
+        std::sort(live.begin(), live.end(), [](Node* a, Node* b) { return a->getId() < b->getId(); });
+
+        EpochStats stats = runLookups(live, lookupCount, rng);
+        size_t resolved = lookupCount - stats.unresolved;
+        double hops = resolved ? (double)stats.hops / resolved : 0;
+        std::cout << "epoch " << epoch << "  live " << live.size()
+                  << "  success " << 100.0 * stats.succeeded / lookupCount << "%"
+                  << "  unresolved " << stats.unresolved
+                  << "  mean hops " << hops << " (extra " << hops - baseHops << ")"
+                  << "  timeouts/lookup " << (resolved ? (double)stats.timeouts / resolved : 0) << "\n";
+
+        // One local stabilize() per node, not a convergence loop
+        for (Node* node : live) node->stabilize();
+    }
+    return 0;
+}
@@ -0,0 +1,209 @@
+// Benchmark suite driver: builds a ring from a reproducible workload (bench/workload.h),
+// inserts the keys, then runs a mix of finds with join/leave churn and periodic
+// maintenance. Every insert, find, join, leave, stabilizeNetwork and fixAllFingers call is
+// timed; routed operations also record their hop count (measured with lookup() outside the
+// timed region). Writes one JSON object with the configuration, ops/sec, latency
+// percentiles and hop-count distributions per operation. The ID width is the BITLENGTH the
+// driver was built with; bench/run_suite.sh builds one binary per width and runs a set of
+// scenarios. --metrics writes the protocol counters (include/metrics.h) after the run, as
+// CSV if the file name ends in .csv and as JSON otherwise.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/dht_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o dht_bench
+// Run:   ./dht_bench [--name=NAME] [--nodes=N] [--keys=N] [--ops=N] [--zipf=S] [--churn=P]
+//                    [--maintain=N] [--seed=N] [--out=FILE] [--metrics=FILE]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+#include "workload.h"
+
+namespace {
+
+struct OpStats {
+    const char* name;
+    const char* countName;           // What `counts` holds (hops, rounds, ...), or nullptr
+    std::vector<uint64_t> latencyNs;
+    std::vector<uint64_t> counts;
+};
+
+uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Nearest-rank percentile of sorted values
+uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)(p * sorted.size());
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void writeDistribution(std::ostream& out, std::vector<uint64_t> values) {
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (uint64_t v : values) sum += (double)v;
+    out << "{\"mean\": " << (values.empty() ? 0 : sum / values.size()) << ", \"p50\": " << percentile(values, 0.5)
+        << ", \"p90\": " << percentile(values, 0.9) << ", \"p99\": " << percentile(values, 0.99)
+        << ", \"p999\": " << percentile(values, 0.999) << ", \"max\": " << (values.empty() ? 0 : values.back())
+        << "}";
+}
+
+void writeStats(std::ostream& out, const OpStats& stats) {
+    double totalNs = 0;
+    for (uint64_t ns : stats.latencyNs) totalNs += (double)ns;
+    out << "    \"" << stats.name << "\": {\"count\": " << stats.latencyNs.size()
+        << ", \"ops_per_sec\": " << (totalNs > 0 ? stats.latencyNs.size() / (totalNs * 1e-9) : 0)
+        << ", \"latency_ns\": ";
+    writeDistribution(out, stats.latencyNs);
+    if (stats.countName) {
+        out << ", \"" << stats.countName << "\": ";
+        writeDistribution(out, stats.counts);
+    }
+    out << "}";
+}
+
+bool parseArg(const char* arg, const char* name, std::string& value) {
+    size_t len = strlen(name);
+    if (strncmp(arg, "--", 2) != 0 || strncmp(arg + 2, name, len) != 0 || arg[2 + len] != '=') return false;
+    value = arg + 3 + len;
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    WorkloadConfig config;
+    std::string name = "default", outPath, metricsPath, value;
+    for (int i = 1; i < argc; ++i) {
+        if (parseArg(argv[i], "name", value)) name = value;
+        else if (parseArg(argv[i], "nodes", value)) config.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        else if (parseArg(argv[i], "keys", value)) config.keys = std::strtoull(value.c_str(), nullptr, 10);
+        else if (parseArg(argv[i], "ops", value)) config.ops = std::strtoull(value.c_str(), nullptr, 10);
+        else if (parseArg(argv[i], "zipf", value)) config.zipf = std::strtod(value.c_str(), nullptr);
+        else if (parseArg(argv[i], "churn", value)) config.churn = std::strtod(value.c_str(), nullptr);
+        else if (parseArg(argv[i], "maintain", value)) config.maintainEvery = std::strtoull(value.c_str(), nullptr, 10);
+        else if (parseArg(argv[i], "seed", value)) config.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (parseArg(argv[i], "out", value)) outPath = value;
+        else if (parseArg(argv[i], "metrics", value)) metricsPath = value;
+        else {
+            std::cerr << "unknown argument " << argv[i] << "\n";
+            return 2;
+        }
+    }
+
+    if (config.nodes == 0) {
+        std::cerr << "--nodes must be at least 1\n";
+        return 2;
+    }
+
+    Workload workload = generateWorkload(config);
+    Ring ring;
+    ring.bootstrap(workload.nodeIds);
+    std::vector<Node*> live = ring.activeNodes();
+
+    OpStats insert{"insert", "hops", {}, {}};
+    OpStats find{"find", "hops", {}, {}};
+    OpStats join{"join", "hops", {}, {}};
+    OpStats leave{"leave", nullptr, {}, {}};
+    OpStats stabilize{"stabilizeNetwork", "rounds", {}, {}};
+    OpStats fixFingers{"fixAllFingers", "fingers_changed", {}, {}};
+
+    auto wall = std::chrono::steady_clock::now();
+    for (const WorkloadOp& op : workload.ops) {
+        Node* origin = live.empty() ? nullptr : live[op.pick % live.size()];
+        switch (op.type) {
+        case OpType::Insert: {
+            Value stored(Blob(&op.key, sizeof(op.key)));
+            auto start = std::chrono::steady_clock::now();
+            origin->insert(op.key, std::move(stored));
+            insert.latencyNs.push_back(elapsedNs(start));
+            insert.counts.push_back(origin->lookup(op.key).hops);
+            break;
+        }
+        case OpType::Find: {
+            auto start = std::chrono::steady_clock::now();
+            origin->find(op.key);
+            find.latencyNs.push_back(elapsedNs(start));
+            find.counts.push_back(origin->lookup(op.key).hops);
+            break;
+        }
+        case OpType::Join: {
+            join.counts.push_back(origin->lookup(op.key).hops);
+            Node* node = ring.addNode(op.key);
+            auto start = std::chrono::steady_clock::now();
+            node->join(origin);
+            join.latencyNs.push_back(elapsedNs(start));
+            live.push_back(node);
+            break;
+        }
+        case OpType::Leave: {
+            if (live.size() <= 1) break;
+            auto start = std::chrono::steady_clock::now();
+            origin->leave();
+            leave.latencyNs.push_back(elapsedNs(start));
+            std::swap(live[op.pick % live.size()], live.back());
+            live.pop_back();
+            break;
+        }
+        case OpType::Maintain: {
+            auto start = std::chrono::steady_clock::now();
+            int rounds = ring.stabilizeNetwork();
+            stabilize.latencyNs.push_back(elapsedNs(start));
+            stabilize.counts.push_back(rounds);
+            start = std::chrono::steady_clock::now();
+            int changed = ring.fixAllFingers();
+            fixFingers.latencyNs.push_back(elapsedNs(start));
+            fixFingers.counts.push_back(changed);
+            break;
+        }
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall).count();
+
+    std::ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file) {
+            std::cerr << "cannot write " << outPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = outPath.empty() ? std::cout : file;
+    out << "{\n  \"scenario\": \"" << name << "\",\n"
+        << "  \"config\": {\"bits\": " << BITLENGTH << ", \"nodes\": " << workload.nodeIds.size()
+        << ", \"keys\": " << config.keys << ", \"ops\": " << config.ops << ", \"zipf\": " << config.zipf
+        << ", \"churn\": " << config.churn << ", \"maintain_every\": " << config.maintainEvery
+        << ", \"seed\": " << config.seed << ", \"successor_list\": " << SUCCESSOR_LIST_LENGTH
+        << ", \"replication\": " << REPLICATION_FACTOR << "},\n"
+        << "  \"final_nodes\": " << live.size() << ",\n"
+        << "  \"wall_seconds\": " << wallSeconds << ",\n"
+        << "  \"ops\": {\n";
+    const OpStats* all[] = {&insert, &find, &join, &leave, &stabilize, &fixFingers};
+    for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i) {
+        writeStats(out, *all[i]);
+        out << (i + 1 < sizeof(all) / sizeof(all[0]) ? ",\n" : "\n");
+    }
+    out << "  }\n}\n";
+
+    if (!metricsPath.empty()) {
+        std::ofstream metricsFile(metricsPath);
+        if (!metricsFile) {
+            std::cerr << "cannot write " << metricsPath << "\n";
+            return 1;
+        }
+        MetricsSnapshot snapshot = ring.metrics();
+        bool csv = metricsPath.size() >= 4 && metricsPath.compare(metricsPath.size() - 4, 4, ".csv") == 0;
+        if (csv) snapshot.writeCsv(metricsFile);
+        else snapshot.writeJson(metricsFile);
+    }
+    return 0;
+}
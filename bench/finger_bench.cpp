@@ -0,0 +1,89 @@
+// Microbenchmark: closest_preceding_finger over the SoA finger table versus
+// the previous pointer-chasing scan (dereference every finger node for its ID).
+//
+// Build: g++ -std=c++17 -O3 -march=native -DBITLENGTH=64 -Iinclude bench/finger_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o finger_bench
+// Run:   ./finger_bench [nodes] [queries] [seed]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// The scan closest_preceding_finger used before the finger IDs were cached
+static Node* pointerScan(Node* self, NodeId key) {
+    for (int i = BITLENGTH; i >= 1; i--) {
+        Node* f = self->getFinger(i);
+        if (f && f != self && ChordSpace::inInterval(f->getId(), self->getId(), key, false, false)) {
+            return f;
+        }
+    }
+    return self;
+}
+
+static Node* soaScan(Node* self, NodeId key) {
+    const FingerTable& fingers = self->getFingerTable();
+    int i = fingers.closestPreceding(self->getId(), key);
+    return i ? fingers.get(i) : self;
+}
+
+template <typename Scan>
+static double timeScan(Scan scan, const std::vector<Node*>& origins, const std::vector<NodeId>& keys,
+                       uint64_t& checksum) {
+    Clock::time_point t = Clock::now();
+    for (size_t q = 0; q < keys.size(); ++q) {
+        checksum += scan(origins[q], keys[q])->getHandle();
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - t).count() / keys.size();
+}
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t queries = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+    uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 42;
+
+    std::mt19937_64 rng(seed);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+
+    Ring ring;
+    ring.bootstrap(ids);
+
+    std::vector<Node*> origins(queries);
+    std::vector<NodeId> keys(queries);
+    for (size_t q = 0; q < queries; ++q) {
+        origins[q] = ring.node((NodeHandle)(rng() % ring.size()));
+        keys[q] = (NodeId)rng();
+    }
+
+    // Both scans must pick the same finger for every query
+    for (size_t q = 0; q < queries; ++q) {
+        if (pointerScan(origins[q], keys[q]) != soaScan(origins[q], keys[q])) {
+            std::cerr << "mismatch at query " << q << "\n";
+            return 1;
+        }
+    }
+
+    uint64_t pointerSum = 0, soaSum = 0;
+    double pointerNs = timeScan(pointerScan, origins, keys, pointerSum);
+    double soaNs = timeScan(soaScan, origins, keys, soaSum);
+
+    Clock::time_point t = Clock::now();
+    uint64_t hops = 0;
+    for (size_t q = 0; q < queries; ++q) {
+        hops += origins[q]->lookup(keys[q]).hops;
+    }
+    double lookupNs = std::chrono::duration<double, std::nano>(Clock::now() - t).count() / queries;
+
+    std::cout << "bits=" << BITLENGTH << " nodes=" << ring.size() << " queries=" << queries << "\n"
+              << "pointer_scan_ns=" << pointerNs << "\n"
+              << "soa_scan_ns=" << soaNs << "\n"
+              << "lookup_ns=" << lookupNs << " mean_hops=" << (double)hops / queries << "\n"
+              << "checksum=" << (pointerSum == soaSum ? "ok" : "MISMATCH") << "\n";
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Key hashing throughput: millions of string keys ("user:<n>", plus some longer keys) mapped
+// onto the ring one at a time with hashKey() and in one hashKeys() batch, for SHA-1 and
+// xxHash64. Batched results are checked against the one-at-a-time ones. Add -mavx2 (or
+// -march=native) to give the SHA-1 lanes full-width vector registers.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -Iinclude bench/hash_bench.cpp src/key_hash.cpp
+//            src/value.cpp -o hash_bench
+// Run:   ./hash_bench [keys]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "key_hash.h"
+
+namespace {
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run(const char* name, KeyHash hash, const std::vector<std::string>& keys) {
+    std::vector<NodeId> single(keys.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) single[i] = hashKey(keys[i], hash);
+    double one = seconds(start);
+
+    std::vector<NodeId> batched(keys.size());
+    start = std::chrono::steady_clock::now();
+    hashKeys(keys, batched.data(), hash);
+    double batch = seconds(start);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < keys.size(); ++i) mismatches += !(single[i] == batched[i]);
+    std::cout << name << "  one-by-one " << keys.size() / one / 1e6 << " M keys/s"
+              << "  batched " << keys.size() / batch / 1e6 << " M keys/s"
+              << "  mismatches " << mismatches << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+
+    // Mostly short keys, one in eight a longer path-like key
+    std::mt19937_64 rng(31);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 8 == 7) {
+            keys.push_back("/objects/bucket-" + std::to_string(rng() % 1000) + "/" + std::to_string(rng()) +
+                           "/" + std::to_string(rng()) + ".bin");
+        } else {
+            keys.push_back("user:" + std::to_string(rng() % 100000000));
+        }
+    }
+
+    std::cout << "keys=" << count << " bits=" << BITLENGTH << "\n";
+    run("SHA-1   ", KeyHash::Sha1, keys);
+    run("xxHash64", KeyHash::XXH64, keys);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Compares the local key-store backends (std::map baseline, flat vector, open addressing).
+//
+// Build: g++ -std=c++17 -O2 -Iinclude -DBITLENGTH=64 bench/key_store_bench.cpp -o key_store_bench
+// Run:   ./key_store_bench [keys] [seed]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "key_store.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedNs(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (ops ? ops : 1);
+}
+
+template <typename Store>
+static void runBackend(const std::string& name, const std::vector<NodeId>& keys,
+                       const std::vector<NodeId>& probes) {
+    Store store;
+
+    Clock::time_point t = Clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        store.put(keys[i], (int)i);
+    }
+    double insertNs = elapsedNs(t, keys.size());
+
+    t = Clock::now();
+    size_t hits = 0;
+    for (const NodeId& key : probes) {
+        if (store.find(key)) ++hits;
+    }
+    double findNs = elapsedNs(t, probes.size());
+
+    // Migration scan: pull out an eighth of the ring, as a join would.
+    NodeId a = keys[0];
+    NodeId b = ChordSpace::add(a, ChordSpace::pow2(BITLENGTH - 3));
+    std::vector<typename Store::Entry> moved;
+    t = Clock::now();
+    store.extractInterval(a, b, moved);
+    double extractUs = std::chrono::duration<double, std::micro>(Clock::now() - t).count();
+
+    t = Clock::now();
+    size_t erased = 0;
+    for (const NodeId& key : probes) {
+        if (store.erase(key)) ++erased;
+    }
+    double eraseNs = elapsedNs(t, probes.size());
+
+    std::cout << name << "\t" << insertNs << "\t" << findNs << "\t" << extractUs
+              << "\t" << eraseNs << "\t" << hits << "\t" << moved.size() << "\t" << erased << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 42;
+
+    std::mt19937_64 rng(seed);
+    std::vector<NodeId> keys(count);
+    for (NodeId& key : keys) key = (NodeId)rng();
+
+    // Half of the probes hit stored keys, half miss.
+    std::vector<NodeId> probes(count);
+    for (size_t i = 0; i < count; ++i) {
+        probes[i] = (i % 2 == 0) ? keys[rng() % count] : (NodeId)rng();
+    }
+
+    std::cout << "backend\tinsert_ns\tfind_ns\textract_us\terase_ns\thits\textracted\terased\n";
+    runBackend<MapKeyStore<int>>("map", keys, probes);
+    runBackend<FlatKeyStore<int>>("flat", keys, probes);
+    runBackend<HashKeyStore<int>>("hash", keys, probes);
+    return 0;
+}
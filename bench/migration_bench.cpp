@@ -0,0 +1,135 @@
+// Key migration: moves an interval of keys between two stores, first the old way
+// (extractInterval into a vector, then one put per key) and then with moveInterval(), for
+// each KeyStore backend. Then joins and leaves nodes of a loaded ring with one splice and
+// in streaming chunks, reporting the longest single step (join, leave or stabilizeNetwork
+// round) a caller has to wait for.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/migration_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o migration_bench
+// Run:   ./migration_bench [keys] [nodes] [chunk]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "key_store.h"
+#include "node.h"
+#include "ring.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Store>
+static void fill(Store& store, const std::vector<NodeId>& keys) {
+    for (const NodeId& key : keys) store.put(key, Value(Blob("value")));
+}
+
+// Moves (a, b] out of a store holding `keys` into one holding `others`
+template <typename Store>
+static void runBackend(const std::string& name, const std::vector<NodeId>& keys,
+                       const std::vector<NodeId>& others, const NodeId& a, const NodeId& b) {
+    Store from, to;
+    fill(from, keys);
+    fill(to, others);
+    Clock::time_point t = Clock::now();
+    std::vector<typename Store::Entry> moved;
+    from.extractInterval(a, b, moved);
+    for (auto& kv : moved) to.put(kv.first, std::move(kv.second));
+    double perKey = elapsedMs(t);
+
+    Store from2, to2;
+    fill(from2, keys);
+    fill(to2, others);
+    t = Clock::now();
+    size_t count = from2.moveInterval(a, b, to2, (size_t)-1);
+    double splice = elapsedMs(t);
+
+    std::cout << name << ": " << count << " keys, extract + put " << perKey << " ms, moveInterval " << splice
+              << " ms" << (count == moved.size() && to.size() == to2.size() ? "" : "  MISMATCH") << "\n";
+}
+
+// Joins a node for each of `ids`, then makes them leave again; returns the longest step in ms
+static double churn(Ring& ring, const std::vector<NodeId>& ids, size_t chunk, size_t& rounds) {
+    Node* known = ring.node(0);
+    double longest = 0;
+    std::vector<Node*> joined;
+    auto settle = [&](Node* receiver) {
+        while (receiver->migrating()) {
+            Clock::time_point t = Clock::now();
+            ring.stabilizeNetwork();
+            longest = std::max(longest, elapsedMs(t));
+            rounds++;
+        }
+    };
+    for (const NodeId& id : ids) {
+        Node* node = ring.addNode(id);
+        Clock::time_point t = Clock::now();
+        node->join(known, chunk);
+        longest = std::max(longest, elapsedMs(t));
+        settle(node);
+        joined.push_back(node);
+    }
+    for (Node* node : joined) {
+        Node* successor = node->getSuccessor();
+        Clock::time_point t = Clock::now();
+        node->leave(chunk);
+        longest = std::max(longest, elapsedMs(t));
+        settle(successor);
+    }
+    return longest;
+}
+
+int main(int argc, char** argv) {
+    size_t keyCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    size_t nodeCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+    size_t chunk = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4096;
+    if (nodeCount < 2) nodeCount = 2;
+    if (chunk == 0) chunk = 1;
+
+    std::mt19937_64 rng(7);
+    std::vector<NodeId> keys(keyCount), others(keyCount);
+    for (NodeId& key : keys) key = (NodeId)rng();
+    for (NodeId& key : others) key = (NodeId)rng();
+    // A quarter of the ring, starting at a random point
+    NodeId a = (NodeId)rng();
+    NodeId b = ChordSpace::add(a, ChordSpace::pow2(BITLENGTH - 2));
+
+    std::cout << "Moving a quarter of the ring between two stores of " << keyCount << " keys\n";
+    runBackend<FlatKeyStore<Value>>("flat", keys, others, a, b);
+    runBackend<HashKeyStore<Value>>("hash", keys, others, a, b);
+    runBackend<MapKeyStore<Value>>("map ", keys, others, a, b);
+
+    std::vector<NodeId> ids(nodeCount), joiners(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+    for (NodeId& id : joiners) id = (NodeId)rng();
+    std::vector<std::pair<NodeId, Value>> items;
+    items.reserve(keyCount);
+    for (const NodeId& key : keys) items.emplace_back(key, Value(Blob("value")));
+
+    std::cout << "\nJoining and leaving " << nodeCount << " nodes in a ring of " << nodeCount << " nodes and "
+              << keyCount << " keys\n";
+    for (size_t step : {(size_t)0, chunk}) {
+        Ring ring;
+        std::vector<std::pair<NodeId, Value>> copy;
+        copy.reserve(items.size());
+        for (const auto& kv : items) copy.emplace_back(kv.first, cloneValue(kv.second));
+        ring.bootstrap(ids, std::move(copy));
+        size_t rounds = 0;
+        Clock::time_point t = Clock::now();
+        double longest = churn(ring, joiners, step, rounds);
+        double total = elapsedMs(t);
+        size_t stored = 0;
+        for (Node* node : ring.activeNodes()) stored += node->keyCount();
+        std::cout << (step ? "chunks of " + std::to_string(step) : std::string("one splice    ")) << ": total "
+                  << total << " ms, longest step " << longest << " ms, " << rounds << " stabilize rounds"
+                  << (stored == keyCount ? "" : "  KEYS LOST") << "\n";
+    }
+    return 0;
+}
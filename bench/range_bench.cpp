@@ -0,0 +1,99 @@
+// Range scans: ranges of several widths over a bootstrapped ring, answered by walking
+// successors from the node responsible for the start, by fanning out to the covering nodes
+// in parallel, and by one get() per key known to be in the range. Reports keys returned,
+// nodes visited, routing hops and time per query; the scans are checked against the keys.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/range_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o range_bench
+// Run:   ./range_bench [nodes] [keys] [queries] [threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+
+namespace {
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    size_t keyCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    size_t queries = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 200;
+    unsigned threads = argc > 4 ? (unsigned)std::strtoul(argv[4], nullptr, 10) : 0;
+
+    std::mt19937_64 rng(37);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+    std::vector<NodeId> keyIds(keyCount);
+    std::vector<std::pair<NodeId, Value>> keys;
+    keys.reserve(keyCount);
+    for (NodeId& id : keyIds) {
+        id = (NodeId)rng();
+        keys.emplace_back(id, Value(Blob(&id, sizeof(id))));
+    }
+    std::sort(keyIds.begin(), keyIds.end());
+    keyIds.erase(std::unique(keyIds.begin(), keyIds.end()), keyIds.end());
+
+    Ring ring;
+    ring.bootstrap(ids, std::move(keys));
+    std::cout << "nodes=" << ring.size() << " keys=" << keyIds.size() << " queries=" << queries
+              << " bits=" << BITLENGTH << "\n";
+
+    // Widths as a share of the ring: about 10, 1000 and 100000 keys at the defaults
+    const size_t spans[] = {10, 1000, 100000};
+    for (size_t span : spans) {
+        span = std::min(span, keyIds.size());
+        std::mt19937_64 opRng(41);
+        std::vector<std::pair<Node*, size_t>> picks(queries);
+        for (auto& pick : picks) {
+            pick.first = ring.node((NodeHandle)(opRng() % ring.size()));
+            pick.second = opRng() % (keyIds.size() - span + 1);
+        }
+
+        size_t returned = 0, wrong = 0;
+        long hops = 0, visited = 0;
+        double walkTime = 0, fanTime = 0, getTime = 0;
+        for (const auto& pick : picks) {
+            NodeId a = keyIds[pick.second];
+            NodeId b = keyIds[pick.second + span - 1];
+
+            RangeScanStats stats;
+            auto start = std::chrono::steady_clock::now();
+            auto walked = pick.first->rangeQuery(a, b, ScanMode::Walk, 0, &stats);
+            walkTime += seconds(start);
+
+            start = std::chrono::steady_clock::now();
+            auto fanned = pick.first->rangeQuery(a, b, ScanMode::FanOut, threads);
+            fanTime += seconds(start);
+
+            start = std::chrono::steady_clock::now();
+            size_t found = 0;
+            for (size_t i = 0; i < span; ++i) found += pick.first->get(keyIds[pick.second + i]) != nullptr;
+            getTime += seconds(start);
+
+            returned += walked.size();
+            hops += stats.hops;
+            visited += stats.nodes;
+            wrong += walked.size() != span || fanned.size() != span || found != span || !stats.complete;
+            for (size_t i = 0; i < walked.size() && i < span; ++i) {
+                wrong += !(walked[i].first == keyIds[pick.second + i]) || !(fanned[i].first == walked[i].first);
+            }
+        }
+
+        std::cout << "range ~" << span << " keys  returned " << (double)returned / queries
+                  << "  nodes " << (double)visited / queries << "  hops " << (double)hops / queries
+                  << "  walk " << 1e6 * walkTime / queries << " us  fan-out " << 1e6 * fanTime / queries
+                  << " us  per-key gets " << 1e6 * getTime / queries << " us  wrong " << wrong << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Replication: Zipf-skewed reads over a bootstrapped ring, then abrupt failures. Reports
+// mean hops, the busiest node's share of reads (max/mean), and the fraction of keys still
+// readable right after 10% of the nodes fail, and again after the ring re-stabilizes and
+// another 10% fail. Then nodes join with their keys streamed in small chunks, and the node
+// each one pulls from fails mid-stream; with replication every key should still be held by
+// its owner afterwards.
+// Build once with the default REPLICATION_FACTOR (1) and once with e.g.
+// -DREPLICATION_FACTOR=3 to compare.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -DREPLICATION_FACTOR=3 -Iinclude
+//            bench/replica_bench.cpp src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp
+//            src/node.cpp src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o replica_bench
+// Run:   ./replica_bench [nodes] [keys] [reads] [zipf_s]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+#include "zipf.h"
+
+namespace {
+
+void readLoad(Ring& ring, const std::vector<NodeId>& keyIds, const Zipf& zipf, size_t reads,
+              std::mt19937_64& rng) {
+    std::vector<Node*> live = ring.activeNodes();
+    ring.resetRequestCounts();
+    size_t hops = 0;
+    size_t found = 0;
+    for (size_t i = 0; i < reads; ++i) {
+        Node* origin = live[rng() % live.size()];
+        NodeId key = keyIds[zipf(rng)];
+        hops += origin->lookup(key, false, REPLICATION_FACTOR > 1).hops;
+        found += origin->get(key) != nullptr;
+    }
+    uint64_t busiest = 0;
+    for (Node* node : live) busiest = std::max(busiest, node->getRequestsServed());
+    std::cout << "zipf reads     mean hops " << (double)hops / reads
+              << "  busiest node max/mean " << busiest / ((double)reads / live.size())
+              << "  found " << 100.0 * found / reads << "%\n";
+}
+
+void readable(const char* label, Ring& ring, const std::vector<NodeId>& keyIds, std::mt19937_64& rng) {
+    std::vector<Node*> live = ring.activeNodes();
+    size_t found = 0;
+    for (const NodeId& key : keyIds) {
+        found += live[rng() % live.size()]->get(key) != nullptr;
+    }
+    // get() falls back on replicas; a key its owner lost is only readable until they go too
+    size_t owned = 0;
+    for (Node* node : live) owned += node->keyCount();
+    std::cout << label << "  live " << live.size() << "  keys readable "
+              << 100.0 * found / keyIds.size() << "%  held by owner " << 100.0 * owned / keyIds.size() << "%\n";
+}
+
+void failFraction(Ring& ring, double fraction, std::mt19937_64& rng) {
+    std::vector<Node*> live = ring.activeNodes();
+    std::shuffle(live.begin(), live.end(), rng);
+    for (size_t i = 0; i < (size_t)(live.size() * fraction); ++i) live[i]->fail();
+}
+
+// Each join streams its keys two at a time, and its successor (the source) fails before the
+// stream is done; the ring is stabilized after every join, which ends any stream still going
+void failStreamingSources(Ring& ring, size_t joins, std::mt19937_64& rng) {
+    for (size_t i = 0; i < joins; ++i) {
+        std::vector<Node*> live = ring.activeNodes();
+        Node* node = ring.addNode((NodeId)rng());
+        node->join(live[rng() % live.size()], 2);
+        if (node->migrating()) node->getSuccessor()->fail();
+        ring.stabilizeNetwork();
+        node->finishMigration();
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    size_t keyCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    size_t reads = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+    double s = argc > 4 ? std::strtod(argv[4], nullptr) : 0.99;
+
+    std::mt19937_64 rng(29);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+    std::vector<NodeId> keyIds(keyCount);
+    std::vector<std::pair<NodeId, Value>> keys;
+    keys.reserve(keyCount);
+    for (NodeId& id : keyIds) {
+        id = (NodeId)rng();
+        keys.emplace_back(id, Value(Blob(&id, sizeof(id))));
+    }
+
+    Ring ring;
+    ring.bootstrap(ids, std::move(keys));
+    std::cout << "nodes=" << ring.size() << " keys=" << keyCount << " reads=" << reads << " zipf_s=" << s
+              << " replication=" << REPLICATION_FACTOR << " bits=" << BITLENGTH << "\n";
+
+    readLoad(ring, keyIds, Zipf(keyCount, s), reads, rng);
+
+    failFraction(ring, 0.1, rng);
+    readable("10% failed        ", ring, keyIds, rng);
+
+    ring.stabilizeNetwork();
+    ring.fixAllFingers();
+    readable("re-stabilized     ", ring, keyIds, rng);
+
+    failFraction(ring, 0.1, rng);
+    readable("another 10% failed", ring, keyIds, rng);
+
+    ring.stabilizeNetwork();
+    ring.fixAllFingers();
+    readable("re-stabilized     ", ring, keyIds, rng);
+
+    failStreamingSources(ring, 20, rng);
+    ring.fixAllFingers();
+    readable("20 sources failed ", ring, keyIds, rng);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Serial vs parallel (double-buffered) maintenance rounds on a perturbed ring: half the
+// nodes bootstrapped, half joined (leaving stale fingers), successors skipped ahead and
+// predecessors cleared. Prints rounds, wall time and a checksum of the final links and
+// fingers; parallel runs give the same checksum for every thread count.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/round_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp src/node_pool.cpp src/ring.cpp
+//            src/value.cpp -pthread -o round_bench
+// Run:   ./round_bench [nodes] [max_threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+
+namespace {
+
+void buildPerturbed(Ring& ring, size_t nodeCount) {
+    std::mt19937_64 rng(7);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+
+    ring.bootstrap(std::vector<NodeId>(ids.begin(), ids.begin() + nodeCount / 2));
+    Node* known = ring.node(0);
+    for (size_t i = nodeCount / 2; i < nodeCount; ++i) {
+        ring.addNode(ids[i])->join(known);
+    }
+
+    // Every node skips 0..7 nodes ahead and forgets its predecessor
+    std::vector<Node*> byId = ring.activeNodes();
+    std::sort(byId.begin(), byId.end(), [](Node* a, Node* b) { return a->getId() < b->getId(); });
+    for (size_t i = 0; i < byId.size(); ++i) {
+        byId[i]->setSuccessor(byId[(i + 1 + rng() % 8) % byId.size()]);
+        byId[i]->setPredecessor(nullptr);
+    }
+}
+
+uint64_t checksum(const Ring& ring) {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+    for (Node* node : ring.nodes()) {
+        mix(node->getSuccessor()->getHandle());
+        mix(node->getPredecessor() ? node->getPredecessor()->getHandle() : kNullHandle);
+        for (int i = 1; i <= BITLENGTH; ++i) mix(node->getFingerTable().getHandle(i));
+    }
+    return h;
+}
+
+void run(size_t nodeCount, RoundMode mode, unsigned threads) {
+    Ring ring;
+    buildPerturbed(ring, nodeCount);
+
+    auto start = std::chrono::steady_clock::now();
+    int rounds = ring.stabilizeNetwork(mode, threads);
+    double stabilize = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    int changed = ring.fixAllFingers(mode, threads);
+    double fix = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << (mode == RoundMode::Serial ? "serial          " : "parallel threads=") ;
+    if (mode == RoundMode::Parallel) std::cout << threads;
+    std::cout << "  stabilize " << rounds << " rounds " << stabilize * 1e3 << " ms"
+              << "  fix_fingers " << changed << " changed " << fix * 1e3 << " ms"
+              << "  checksum " << std::hex << checksum(ring) << std::dec << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50000;
+    unsigned maxThreads = argc > 2 ? (unsigned)std::strtoul(argv[2], nullptr, 10)
+                                   : std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "nodes=" << nodeCount << " bits=" << BITLENGTH << "\n";
+    run(nodeCount, RoundMode::Serial, 1);
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        run(nodeCount, RoundMode::Parallel, threads);
+    }
+    return 0;
+}
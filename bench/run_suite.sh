@@ -0,0 +1,44 @@
+#!/bin/sh
+# Runs the scenarios of bench/scenarios.txt (or the file given as $1) with bench/dht_bench.cpp,
+# building one driver per ID width. Each scenario writes <out>/<name>.json; all of them are
+# also collected into <out>/results.json as one JSON array.
+#
+# Run from the repository root: bench/run_suite.sh [scenarios] [out_dir]
+# Environment: CXX (default g++), CXXFLAGS (default -O2).
+
+set -e
+scenarios=${1:-bench/scenarios.txt}
+out=${2:-bench_results}
+cxx=${CXX:-g++}
+flags=${CXXFLAGS:--O2}
+mkdir -p "$out"
+
+sources="bench/dht_bench.cpp src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp
+         src/node.cpp src/node_pool.cpp src/ring.cpp src/value.cpp"
+
+grep -v '^[[:space:]]*#' "$scenarios" | grep -v '^[[:space:]]*$' |
+while read -r name bits nodes keys ops zipf churn maintain seed; do
+    bin="$out/dht_bench_$bits"
+    if [ ! -x "$bin" ]; then
+        echo "building $bin" >&2
+        $cxx -std=c++17 $flags -DBITLENGTH="$bits" -DDHT_LOG_LEVEL=0 -Iinclude $sources -pthread -o "$bin"
+    fi
+    echo "running $name" >&2
+    "$bin" --name="$name" --nodes="$nodes" --keys="$keys" --ops="$ops" --zipf="$zipf" --churn="$churn" \
+           --maintain="$maintain" --seed="$seed" --out="$out/$name.json"
+    echo "$out/$name.json"
+done > "$out/.files"
+
+# Collect the per-scenario objects into one array
+{
+    echo "["
+    sep=""
+    while read -r file; do
+        printf '%s' "$sep"
+        cat "$file"
+        sep=","
+    done < "$out/.files"
+    echo "]"
+} > "$out/results.json"
+rm -f "$out/.files"
+echo "wrote $out/results.json" >&2
@@ -0,0 +1,53 @@
+// Discrete-event run: lookups plus periodic stabilize/fix_fingers over a bootstrapped ring,
+// reporting lookup latency percentiles under the configured link model.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/sim_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp src/node_pool.cpp src/ring.cpp
+//            src/simulator.cpp src/value.cpp -pthread -o sim_bench
+// Run:   ./sim_bench [nodes] [lookups] [seconds] [loss] [seed]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+#include "simulator.h"
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t lookupCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 10.0;
+    double loss = argc > 4 ? std::atof(argv[4]) : 0.0;
+    uint64_t seed = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 1;
+
+    std::mt19937_64 rng(seed);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+
+    Ring ring;
+    ring.bootstrap(ids);
+
+    SimConfig config;
+    config.link.lossRate = loss;
+    config.seed = seed;
+    Simulator sim(ring, config);
+
+    SimTime horizon = (SimTime)(seconds * 1e6);
+    for (size_t i = 0; i < lookupCount; ++i) {
+        SimTime at = rng() % (horizon + 1);
+        sim.scheduleLookup(at, ring.node((NodeHandle)(rng() % ring.size())), (NodeId)rng());
+    }
+    sim.startMaintenance(horizon);
+
+    auto start = std::chrono::steady_clock::now();
+    sim.run();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    SimReport report = sim.report();
+    std::cout << "nodes=" << ring.size() << " bits=" << BITLENGTH << " loss=" << loss << "\n";
+    report.print(std::cout);
+    std::cout << "wall_s=" << wall << " events_per_s=" << report.events / wall << "\n";
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Ring snapshots: builds a converged ring the slow way (half the nodes bootstrapped, the
+// other half joined through the protocol, then stabilizeNetwork + fixAllFingers), stores
+// keys, and saves it with Ring::save(). Then maps the file with RingSnapshot and rebuilds
+// the ring with Ring::load(), timing every step, and checks that the loaded ring has the
+// same links, fingers, keys and lookup results as the original.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/snapshot_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/ring_snapshot.cpp src/value.cpp -pthread -o snapshot_bench
+// Run:   ./snapshot_bench [nodes] [keys] [file]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+#include "ring_snapshot.h"
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Handles of the links, successor lists and fingers, plus every key and value
+uint64_t checksum(const Ring& ring) {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+    for (Node* node : ring.nodes()) {
+        mix(hashId(node->getId()));
+        mix(node->isInRing());
+        mix(node->getSuccessor()->getHandle());
+        mix(node->getPredecessor() ? node->getPredecessor()->getHandle() : kNullHandle);
+        for (int k = 0; k < SUCCESSOR_LIST_LENGTH; ++k) mix(node->getSuccessorListEntry(k)->getHandle());
+        for (int i = 1; i <= BITLENGTH; ++i) mix(node->getFingerTable().getHandle(i));
+        mix(node->keyCount());
+        mix(node->replicaCount());
+    }
+    return h;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    size_t keyCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    std::string path = argc > 3 ? argv[3] : "ring.snapshot";
+    if (nodeCount < 2) nodeCount = 2;
+
+    std::mt19937_64 rng(11);
+    std::vector<NodeId> ids(nodeCount);
+    for (NodeId& id : ids) id = (NodeId)rng();
+    std::vector<NodeId> keys(keyCount);
+    for (NodeId& key : keys) key = (NodeId)rng();
+
+    auto start = std::chrono::steady_clock::now();
+    Ring ring;
+    ring.bootstrap(std::vector<NodeId>(ids.begin(), ids.begin() + nodeCount / 2));
+    Node* known = ring.node(0);
+    for (size_t i = nodeCount / 2; i < nodeCount; ++i) {
+        ring.addNode(ids[i])->join(known);
+    }
+    int rounds = ring.stabilizeNetwork();
+    int changed = ring.fixAllFingers();
+    for (size_t i = 0; i < keyCount; ++i) {
+        std::string text = std::to_string(i);
+        known->insert(keys[i], Value(Blob(text)));
+    }
+    double build = secondsSince(start);
+    std::cout << "built " << ring.size() << " nodes, " << keyCount << " keys in " << build << " s ("
+              << rounds << " stabilize rounds, " << changed << " fingers fixed)\n";
+
+    start = std::chrono::steady_clock::now();
+    if (!ring.save(path)) {
+        std::cerr << "cannot write " << path << "\n";
+        return 1;
+    }
+    std::cout << "save  " << secondsSince(start) << " s\n";
+
+    start = std::chrono::steady_clock::now();
+    RingSnapshot snapshot;
+    if (!snapshot.open(path)) {
+        std::cerr << snapshot.error() << "\n";
+        return 1;
+    }
+    double open = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    Ring loaded;
+    loaded.load(snapshot);
+    double load = secondsSince(start);
+    std::cout << "open  " << open << " s (" << snapshot.nodeCount() << " nodes, " << snapshot.keyCount()
+              << " keys)\nload  " << load << " s\n";
+
+    bool same = checksum(ring) == checksum(loaded);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < 100000 && keyCount; ++i) {
+        const NodeId& key = keys[rng() % keyCount];
+        NodeHandle origin = (NodeHandle)(rng() % nodeCount);
+        LookupResult a = ring.node(origin)->lookup(key);
+        LookupResult b = loaded.node(origin)->lookup(key);
+        const Value* va = ring.node(origin)->get(key);
+        const Value* vb = loaded.node(origin)->get(key);
+        if (a.node->getHandle() != b.node->getHandle() || a.hops != b.hops || !va || !vb ||
+            valueToString(*va) != valueToString(*vb)) {
+            mismatches++;
+        }
+    }
+    std::cout << (same && mismatches == 0 ? "state and lookups match" : "MISMATCH") << "\n";
+    return same && mismatches == 0 ? 0 : 1;
+}
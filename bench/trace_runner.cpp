@@ -0,0 +1,125 @@
+// Trace-driven scenario runner: streams a workload trace (text or binary, detected from the
+// first bytes; see include/trace.h) through the Node API of a fresh ring, without loading
+// it into memory, and prints what it did. With --record the applied records are written
+// back out, in either format, with every origin made explicit, so a recording replays the
+// same run (and text and binary traces convert into each other). --metrics writes the
+// protocol counters (include/metrics.h) at the end, as CSV for a .csv file, else as JSON.
+// --ring starts from a ring saved with Ring::save() instead of an empty one, and
+// --save-ring saves the ring the trace left behind.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/trace_runner.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/ring_snapshot.cpp src/trace.cpp src/value.cpp -pthread -o trace_runner
+// Run:   ./trace_runner <trace|-> [--record=FILE] [--format=text|binary] [--metrics=FILE]
+//                       [--ring=FILE] [--save-ring=FILE]
+//        ./trace_runner bench/traces/demo.trace   (the main.cpp scenario; any BITLENGTH >= 8)
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "ring.h"
+#include "ring_snapshot.h"
+#include "trace.h"
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    std::string recordPath, metricsPath, ringPath, saveRingPath;
+    TraceFormat recordFormat = TraceFormat::Text;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--record=", 9) == 0) {
+            recordPath = argv[i] + 9;
+        } else if (strncmp(argv[i], "--metrics=", 10) == 0) {
+            metricsPath = argv[i] + 10;
+        } else if (strncmp(argv[i], "--ring=", 7) == 0) {
+            ringPath = argv[i] + 7;
+        } else if (strncmp(argv[i], "--save-ring=", 12) == 0) {
+            saveRingPath = argv[i] + 12;
+        } else if (strcmp(argv[i], "--format=binary") == 0) {
+            recordFormat = TraceFormat::Binary;
+        } else if (strcmp(argv[i], "--format=text") == 0) {
+            recordFormat = TraceFormat::Text;
+        } else if (!tracePath) {
+            tracePath = argv[i];
+        } else {
+            std::cerr << "unknown argument " << argv[i] << "\n";
+            return 2;
+        }
+    }
+    if (!tracePath) {
+        std::cerr << "usage: trace_runner <trace|-> [--record=FILE] [--format=text|binary] [--metrics=FILE]"
+                     " [--ring=FILE] [--save-ring=FILE]\n";
+        return 2;
+    }
+
+    std::ifstream file;
+    if (strcmp(tracePath, "-") != 0) {
+        file.open(tracePath, std::ios::binary);
+        if (!file) {
+            std::cerr << "cannot open " << tracePath << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = file.is_open() ? file : std::cin;
+
+    std::ofstream recordFile;
+    std::unique_ptr<TraceWriter> recorder;
+    if (!recordPath.empty()) {
+        recordFile.open(recordPath, std::ios::binary);
+        if (!recordFile) {
+            std::cerr << "cannot write " << recordPath << "\n";
+            return 1;
+        }
+        recorder.reset(new TraceWriter(recordFile, recordFormat));
+    }
+
+    Ring ring;
+    if (!ringPath.empty()) {
+        RingSnapshot snapshot;
+        if (!snapshot.open(ringPath)) {
+            std::cerr << snapshot.error() << "\n";
+            return 1;
+        }
+        ring.load(snapshot);
+        std::cout << "loaded " << ring.size() << " nodes from " << ringPath << "\n";
+    }
+    TraceReader reader(in);
+    TraceRunner runner(ring, recorder.get());
+    auto start = std::chrono::steady_clock::now();
+    bool ok = runner.run(reader);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const TraceStats& s = runner.stats();
+    std::cout << "trace " << (reader.format() == TraceFormat::Text ? "text" : "binary") << ", "
+              << reader.records() << " records in " << seconds << " s ("
+              << (seconds > 0 ? reader.records() / seconds : 0) << " records/s)\n"
+              << "applied " << s.applied << "  skipped " << s.skipped << "\n"
+              << "joins " << s.joins << "  leaves " << s.leaves << "  inserts " << s.inserts
+              << "  removes " << s.removes << "\n"
+              << "lookups " << s.lookups << "  unresolved " << s.unresolved << "  mean hops "
+              << (s.lookups ? (double)s.lookupHops / s.lookups : 0) << "\n"
+              << "stabilize rounds " << s.stabilizeRounds << "  fingers changed " << s.fingersChanged << "\n";
+    if (recorder) std::cout << "recorded " << recorder->records() << " records to " << recordPath << "\n";
+    if (!saveRingPath.empty() && !ring.save(saveRingPath)) {
+        std::cerr << "cannot write " << saveRingPath << "\n";
+        return 1;
+    }
+    if (!metricsPath.empty()) {
+        std::ofstream metricsFile(metricsPath);
+        if (!metricsFile) {
+            std::cerr << "cannot write " << metricsPath << "\n";
+            return 1;
+        }
+        MetricsSnapshot snapshot = ring.metrics();
+        bool csv = metricsPath.size() >= 4 && metricsPath.compare(metricsPath.size() - 4, 4, ".csv") == 0;
+        if (csv) snapshot.writeCsv(metricsFile);
+        else snapshot.writeJson(metricsFile);
+    }
+    if (!ok) {
+        std::cerr << "malformed trace: " << reader.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Load balance with virtual nodes: H physical hosts each run V ring positions, for several
+// V. Keys are spread uniformly, requests follow a Zipf distribution over the keys. Reports
+// the busiest host's key and request load relative to the mean (max/mean = 1 is perfect
+// balance; the busiest host bounds throughput), then runs the rebalancer on requests and
+// on keys and reports the result.
+//
+// Build: g++ -std=c++17 -O2 -DBITLENGTH=64 -DDHT_LOG_LEVEL=0 -Iinclude bench/vnode_bench.cpp
+//            src/finger_table.cpp src/key_hash.cpp src/location_cache.cpp src/log.cpp src/metrics.cpp src/node.cpp
+//            src/node_pool.cpp src/ring.cpp src/value.cpp -pthread -o vnode_bench
+// Run:   ./vnode_bench [hosts] [keys] [requests] [zipf_s]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "node.h"
+#include "ring.h"
+#include "zipf.h"
+
+namespace {
+
+void printBalance(const char* label, const Ring& ring) {
+    std::vector<HostLoad> loads = ring.hostLoads();
+    size_t maxKeys = 0, totalKeys = 0;
+    uint64_t maxRequests = 0, totalRequests = 0;
+    for (const HostLoad& load : loads) {
+        maxKeys = std::max(maxKeys, load.keys);
+        totalKeys += load.keys;
+        maxRequests = std::max(maxRequests, load.requests);
+        totalRequests += load.requests;
+    }
+    double meanKeys = (double)totalKeys / loads.size();
+    double meanRequests = (double)totalRequests / loads.size();
+    std::cout << label << "  keys max/mean " << maxKeys / meanKeys
+              << "  requests max/mean " << (meanRequests > 0 ? maxRequests / meanRequests : 0) << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t hostCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+    size_t keyCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    size_t requestCount = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+    double s = argc > 4 ? std::strtod(argv[4], nullptr) : 0.99;
+
+    std::mt19937_64 keyRng(17);
+    std::vector<NodeId> keyIds(keyCount);
+    for (NodeId& id : keyIds) id = (NodeId)keyRng();
+    Zipf zipf(keyCount, s);
+
+    std::cout << "hosts=" << hostCount << " keys=" << keyCount << " requests=" << requestCount
+              << " zipf_s=" << s << " bits=" << BITLENGTH << "\n";
+
+    const size_t virtualCounts[] = {1, 4, 16, 64};
+    for (size_t virtualPerHost : virtualCounts) {
+        std::mt19937_64 rng(19);
+        std::vector<std::pair<NodeId, HostId>> positions;
+        positions.reserve(hostCount * virtualPerHost);
+        for (size_t h = 0; h < hostCount; ++h) {
+            for (size_t v = 0; v < virtualPerHost; ++v) positions.emplace_back((NodeId)rng(), (HostId)h);
+        }
+        std::vector<std::pair<NodeId, Value>> keys;
+        keys.reserve(keyCount);
+        for (const NodeId& id : keyIds) keys.emplace_back(id, Value());
+
+        Ring ring;
+        ring.bootstrapHosts(std::move(positions), std::move(keys));
+
+        std::mt19937_64 opRng(23);
+        for (size_t i = 0; i < requestCount; ++i) {
+            ring.node((NodeHandle)(opRng() % ring.size()))->get(keyIds[zipf(opRng)]);
+        }
+
+        std::cout << "virtual nodes per host " << virtualPerHost << "\n";
+        printBalance("  initial          ", ring);
+        if (virtualPerHost > 1) {
+            int moves = ring.rebalance(LoadMetric::Requests, 1.1);
+            std::cout << "  rebalance(Requests) moved " << moves << " virtual nodes\n";
+            printBalance("  after requests   ", ring);
+            moves = ring.rebalance(LoadMetric::Keys, 1.1);
+            std::cout << "  rebalance(Keys) moved " << moves << " virtual nodes\n";
+            printBalance("  after keys       ", ring);
+        }
+    }
+    return 0;
+}
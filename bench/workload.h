@@ -0,0 +1,107 @@
+// Reproducible workload generator for bench/dht_bench.cpp: node IDs, key IDs and an
+// operation trace derived only from a seed. Random numbers come straight from
+// std::mt19937_64 (no std:: distributions, whose output differs between standard
+// libraries), so a seed gives the same trace everywhere.
+
+#ifndef BENCH_WORKLOAD_H
+#define BENCH_WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <random>
+#include <set>
+#include <vector>
+#include "identifier.h"
+#include "zipf.h"
+
+struct WorkloadConfig {
+    size_t nodes = 1000;           // Initial ring size
+    size_t keys = 10000;           // Keys inserted before the mixed phase
+    size_t ops = 100000;           // Operations in the mixed phase
+    double zipf = 0;               // Access skew of finds; 0 = uniform
+    double churn = 0;              // Probability that a mixed-phase operation is a join or a leave
+    size_t maintainEvery = 10000;  // Mixed-phase operations between maintenance passes (0 = never)
+    uint64_t seed = 1;
+};
+
+enum class OpType { Insert, Find, Join, Leave, Maintain };
+
+struct WorkloadOp {
+    OpType type;
+    uint32_t pick;   // Origin (or the node leaving): live node pick % live count
+    NodeId key;      // Key to insert or find, or ID of the joining node
+};
+
+struct Workload {
+    std::vector<NodeId> nodeIds;   // Initial ring, unique
+    std::vector<NodeId> keyIds;    // Keys, inserted in this order
+    std::vector<WorkloadOp> ops;   // Inserts of every key, then the mixed phase
+};
+
+// Uniform ID on the ring
+inline NodeId randomId(std::mt19937_64& rng) {
+#if BITLENGTH == 160
+    uint8_t bytes[24];
+    for (int w = 0; w < 3; ++w) {
+        uint64_t r = rng();
+        for (int i = 0; i < 8; ++i) bytes[8 * w + i] = (uint8_t)(r >> (56 - 8 * i));
+    }
+    return Uint160::fromBytes(bytes);
+#else
+    return ChordSpace::add(NodeId(0), (NodeId)rng());   // Masked to BITLENGTH bits
+#endif
+}
+
+// Uniform double in [0, 1)
+inline double randomUnit(std::mt19937_64& rng) {
+    return (double)(rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline Workload generateWorkload(const WorkloadConfig& config) {
+    std::mt19937_64 rng(config.seed);
+    Workload w;
+
+    // Node IDs are never reused, so joins always bring a fresh ID
+    std::set<NodeId> used;
+    for (size_t tries = 0; w.nodeIds.size() < config.nodes && tries < 4 * config.nodes + 64; ++tries) {
+        NodeId id = randomId(rng);
+        if (used.insert(id).second) w.nodeIds.push_back(id);
+    }
+
+    w.keyIds.resize(config.keys);
+    for (NodeId& key : w.keyIds) key = randomId(rng);
+    w.ops.reserve(config.keys + config.ops + (config.maintainEvery ? config.ops / config.maintainEvery + 1 : 1));
+    for (const NodeId& key : w.keyIds) w.ops.push_back({OpType::Insert, (uint32_t)rng(), key});
+
+    Zipf zipf(config.zipf > 0 && config.keys ? config.keys : 1, config.zipf);
+    for (size_t i = 0; i < config.ops; ++i) {
+        WorkloadOp op{OpType::Find, (uint32_t)rng(), NodeId()};
+        if (config.churn > 0 && randomUnit(rng) < config.churn) {
+            op.type = (rng() & 1) ? OpType::Join : OpType::Leave;
+        }
+        if (op.type == OpType::Join) {
+            // Skip the join if the ID space is (nearly) full
+            op.type = OpType::Find;
+            for (int tries = 0; tries < 64; ++tries) {
+                NodeId id = randomId(rng);
+                if (used.insert(id).second) {
+                    op.type = OpType::Join;
+                    op.key = id;
+                    break;
+                }
+            }
+        }
+        if (op.type == OpType::Find && !w.keyIds.empty()) {
+            size_t rank = config.zipf > 0 ? zipf(rng) : (size_t)(rng() % w.keyIds.size());
+            op.key = w.keyIds[rank];
+        }
+        w.ops.push_back(op);
+        if (config.maintainEvery && (i + 1) % config.maintainEvery == 0) {
+            w.ops.push_back({OpType::Maintain, 0, NodeId()});
+        }
+    }
+    w.ops.push_back({OpType::Maintain, 0, NodeId()});
+    return w;
+}
+
+#endif  // BENCH_WORKLOAD_H
@@ -0,0 +1,29 @@
+// Zipf rank sampler shared by the benchmarks.
+
+#ifndef BENCH_ZIPF_H
+#define BENCH_ZIPF_H
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Samples ranks 0..n-1 with P(r) proportional to 1 / (r + 1)^s
+class Zipf {
+public:
+    Zipf(size_t n, double s) : cdf_(n) {
+        double sum = 0;
+        for (size_t r = 0; r < n; ++r) cdf_[r] = sum += 1.0 / std::pow((double)(r + 1), s);
+        for (double& c : cdf_) c /= sum;
+    }
+
+    size_t operator()(std::mt19937_64& rng) const {
+        double u = (double)(rng() >> 11) * (1.0 / 9007199254740992.0);   // Same on every standard library
+        return std::min(cdf_.size() - 1, (size_t)(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin()));
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+#endif  // BENCH_ZIPF_H
@@ -0,0 +1,258 @@
+#ifndef ACTOR_RUNTIME_H
+#define ACTOR_RUNTIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "identifier.h"
+#include "finger_table.h"
+#include "key_store.h"
+#include "value.h"
+
+class Node;
+class Ring;
+struct LookupResult;
+struct ActorGetResult;
+
+/**
+ * @struct ActorMessage
+ * @brief One message in a node's mailbox (allocated by the sender, freed by the receiver).
+ */
+struct ActorMessage {
+    std::atomic<ActorMessage*> next;            ///< Mailbox link
+    NodeId key;                                 ///< Key being routed
+    Value value;                                ///< Payload of an insert
+    LookupResult* lookupOut;                    ///< Where a client lookup writes its result
+    ActorGetResult* getOut;                     ///< Where a client get writes its result
+    KeyStore<Value>* keys;                      ///< Keys handed over to the receiver
+    NodeHandle src;                             ///< Sender, or origin of a routed request
+    NodeHandle arg;                             ///< Node carried by the message (result, predecessor, ...)
+    uint16_t hops;                              ///< Forwarding hops so far
+    uint8_t type;                               ///< ActorRuntime::MsgType
+    uint8_t purpose;                            ///< What a routed request does at the responsible node
+    uint8_t finger;                             ///< Finger index being fixed
+};
+
+/**
+ * @class Mailbox
+ * @brief Lock-free multi-producer single-consumer queue of ActorMessages.
+ *
+ * Intrusive linked queue with a stub node: push is one atomic exchange and
+ * one store, pop touches no shared cache line unless the queue is nearly
+ * empty. A pop may return nullptr while a producer is between its two
+ * steps; the message shows up on a later pop.
+ */
+class Mailbox {
+public:
+    Mailbox();
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    /**
+     * @brief Appends a message (any thread).
+     */
+    void push(ActorMessage* message);
+
+    /**
+     * @brief Removes the oldest message, or returns nullptr (owning actor only).
+     */
+    ActorMessage* pop();
+
+private:
+    alignas(64) std::atomic<ActorMessage*> head_;   ///< Last pushed message (producers)
+    alignas(64) ActorMessage* tail_;                ///< Next message to pop (consumer)
+    ActorMessage stub_;
+};
+
+/**
+ * @class WorkStealingDeque
+ * @brief Bounded Chase-Lev deque of actor handles.
+ *
+ * The owning worker pushes and pops at the bottom, other workers steal from
+ * the top. An actor is queued at most once at any time, so a capacity of
+ * the actor count never overflows.
+ */
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacity);
+
+    void push(NodeHandle handle);    ///< Owner only
+    bool pop(NodeHandle& handle);    ///< Owner only
+    bool steal(NodeHandle& handle);  ///< Any thread
+
+private:
+    alignas(64) std::atomic<int64_t> top_;
+    alignas(64) std::atomic<int64_t> bottom_;
+    std::unique_ptr<std::atomic<NodeHandle>[]> buffer_;
+    int64_t mask_;
+};
+
+/**
+ * @struct ActorGetResult
+ * @brief Outcome of ActorRuntime::get.
+ */
+struct ActorGetResult {
+    bool found = false;   ///< Whether the key was stored
+    Value value;          ///< Copy of the stored value
+    Node* node = nullptr; ///< Node that answered
+};
+
+/**
+ * @class ActorRuntime
+ * @brief Runs the nodes of a Ring as actors on a work-stealing thread pool.
+ *
+ * Each node becomes an actor with a lock-free MPSC mailbox. A node's state
+ * (links, finger table, keys) is only touched by its own actor, and nodes
+ * interact purely through messages, so lookups, inserts, gets, joins,
+ * leaves and stabilization of different nodes run concurrently on all
+ * workers. An actor with mail is queued on one worker's deque; idle
+ * workers take from the shared injection queue, then steal.
+ *
+ * Requests are asynchronous: results are written to caller-provided slots
+ * and are valid once waitIdle() returns. While messages are in flight the
+ * nodes belong to the runtime; call waitIdle() before using Node methods
+ * directly. The runtime covers the nodes the ring holds when it is created.
+ */
+class ActorRuntime {
+public:
+    /**
+     * @param ring The ring whose nodes become actors.
+     * @param threads Worker threads; 0 uses all cores.
+     */
+    explicit ActorRuntime(Ring& ring, unsigned threads = 0);
+
+    /**
+     * @brief Waits for all messages to be processed and stops the workers.
+     */
+    ~ActorRuntime();
+
+    ActorRuntime(const ActorRuntime&) = delete;
+    ActorRuntime& operator=(const ActorRuntime&) = delete;
+
+    /**
+     * @brief Routes a lookup for `key` from `origin`; fills `out->node` and `out->hops`.
+     */
+    void lookup(Node* origin, NodeId key, LookupResult* out);
+
+    /**
+     * @brief Routes `value` from `origin` to the node responsible for `key`.
+     */
+    void insert(Node* origin, NodeId key, Value value);
+
+    /**
+     * @brief Routes a read of `key` from `origin`; fills `*out`.
+     */
+    void get(Node* origin, NodeId key, ActorGetResult* out);
+
+    /**
+     * @brief Joins `node` through `knownNode` (nullptr creates a new ring).
+     *
+     * `knownNode` must already be in the ring; requests reaching a node that
+     * never joined are dropped.
+     * The node learns its successor through a lookup and starts with every
+     * finger pointing to it; stabilize() links the predecessor side and moves
+     * the keys the node now owns, fixFingers() refines the fingers.
+     */
+    void join(Node* node, Node* knownNode);
+
+    /**
+     * @brief Hands the node's keys to its successor and links its neighbours to each other.
+     */
+    void leave(Node* node);
+
+    /**
+     * @brief One stabilization round on every node in the ring.
+     */
+    void stabilize();
+
+    /**
+     * @brief Refreshes every finger of every node in the ring through lookups.
+     */
+    void fixFingers();
+
+    /**
+     * @brief Blocks until every message sent so far, and everything it caused, is processed.
+     */
+    void waitIdle();
+
+    /**
+     * @brief Number of worker threads.
+     */
+    unsigned threads() const { return (unsigned)workers_.size(); }
+
+    /**
+     * @brief Messages processed by all workers so far.
+     */
+    uint64_t messagesProcessed() const;
+
+private:
+    enum MsgType : uint8_t {
+        Route,              // One hop of find_successor for a request
+        Resolve,            // The first node from here still in the ring is responsible
+        Store,              // Insert at the responsible node
+        Read,               // Get at the responsible node
+        FingerReply,        // Result of a finger lookup, back to its owner
+        JoinReply,          // Successor found for a joining node
+        StabilizeTick,      // Start stabilize() on a node
+        FixFingersTick,     // Start a lookup for every finger of a node
+        GetPredecessor,     // stabilize(): ask the successor for its predecessor
+        PredecessorReply,   // ... and its answer
+        CheckPredecessor,   // stabilize(): has our predecessor left?
+        Notify,             // stabilize(): tell the successor about ourselves
+        TransferKeys,       // Keys the receiver now owns
+        LeaveTick,          // Start leave() on a node
+        PredecessorLeft,    // The sender left: adopt its predecessor (and its keys, if any)
+        SuccessorLeft       // The sender left: adopt its successor
+    };
+
+    enum Purpose : uint8_t { ForLookup, ForInsert, ForGet, ForFinger, ForJoin };
+
+    struct alignas(64) Actor {
+        Mailbox mailbox;
+        std::atomic<uint32_t> pending{0};   ///< Messages pushed and not yet processed
+    };
+
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> value{0};
+    };
+
+    ActorMessage* newMessage(MsgType type, NodeHandle src);
+    void send(NodeHandle dst, ActorMessage* message);
+    void schedule(NodeHandle handle);
+    void workerLoop(unsigned index);
+    bool findWork(unsigned index, NodeHandle& handle);
+    void runActor(NodeHandle handle, unsigned index);
+    void handle(Node* node, ActorMessage* message);
+
+    void onRoute(Node* node, ActorMessage* message);
+    void deliver(Node* node, Node* responsible, ActorMessage* message);
+    bool forwardToOwner(Node* node, ActorMessage* message);
+    static bool hasLeft(const Node* node);
+    void onPredecessorReply(Node* node, ActorMessage* message);
+    void onNotify(Node* node, ActorMessage* message);
+    void onLeave(Node* node);
+
+    Ring& ring_;
+    size_t actorCount_;
+    std::unique_ptr<Actor[]> actors_;
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques_;
+    std::unique_ptr<Counter[]> sent_;        ///< Per worker, plus one slot for outside threads
+    std::unique_ptr<Counter[]> processed_;   ///< Per worker
+    std::vector<std::thread> workers_;
+
+    std::mutex injectMutex_;
+    std::vector<NodeHandle> injected_;       ///< Actors scheduled from outside the pool
+    std::atomic<bool> hasInjected_;
+
+    std::mutex idleMutex_;
+    std::condition_variable idleCv_;
+    std::atomic<int> sleeping_;
+    std::atomic<bool> stop_;
+};
+
+#endif  // ACTOR_RUNTIME_H
@@ -0,0 +1,246 @@
+#ifndef ASYNC_LOOKUP_H
+#define ASYNC_LOOKUP_H
+
+// Coroutine-based lookups need C++20 (-std=c++20); under older standards
+// this header declares nothing.
+#if defined(__cpp_impl_coroutine)
+
+#include <stddef.h>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "identifier.h"
+#include "node.h"
+#include "value.h"
+
+template <typename T>
+class Task;
+
+namespace async_detail {
+
+// Hands control back to whoever awaits the finished task
+struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> done) noexcept {
+        std::coroutine_handle<> continuation = done.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+    Task<T> get_return_object();
+    void return_value(T result) { value = std::move(result); }
+    T take() { return std::move(*value); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() const noexcept {}
+    void take() const noexcept {}
+};
+
+}  // namespace async_detail
+
+/**
+ * @class Task
+ * @brief Lazily started coroutine producing a T.
+ *
+ * A task runs when it is awaited (`co_await task`) or handed to
+ * AsyncScheduler::spawn(); it resumes its awaiter when it finishes.
+ */
+template <typename T>
+class Task {
+public:
+    using promise_type = async_detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;   // Symmetric transfer: start the task right away
+    }
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    Handle handle_;
+};
+
+namespace async_detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+}  // namespace async_detail
+
+/**
+ * @class AsyncScheduler
+ * @brief Single-threaded scheduler that keeps many lookups and inserts in flight.
+ *
+ * Each request is a coroutine that routes hop by hop like Node::lookup(),
+ * but at every hop it prefetches the next node (its links and finger IDs)
+ * and yields to the other requests. By the time it resumes, the node is
+ * usually in cache, so with enough requests outstanding the memory
+ * latency of one hop hides behind the work of the others.
+ *
+ * Requests start when run() is called and are resumed round-robin, at most
+ * `window` of them at a time. The ring must not change while run() works.
+ */
+class AsyncScheduler {
+public:
+    /**
+     * @param window Requests in flight at once (0 = all submitted requests).
+     */
+    explicit AsyncScheduler(size_t window = 0) : window_(window), active_(0), completed_(0) {}
+
+    AsyncScheduler(const AsyncScheduler&) = delete;
+    AsyncScheduler& operator=(const AsyncScheduler&) = delete;
+
+    /**
+     * @brief Destroys requests that never ran.
+     */
+    ~AsyncScheduler();
+
+    /**
+     * @brief Routes a lookup for `key` from `origin`; await it inside another task.
+     *
+     * Same result as origin->lookup(key) (paths are not recorded).
+     */
+    Task<LookupResult> lookup(Node* origin, NodeId key);
+
+    /**
+     * @brief Routes `value` from `origin` and stores it at the node responsible for `key`.
+     *
+     * Like Node::insert() with REPLICATION_FACTOR 1, but without the
+     * location cache; replicas are not written.
+     * @return The node that stored the key (nullptr if none was found).
+     */
+    Task<Node*> insert(Node* origin, NodeId key, Value value);
+
+    /**
+     * @brief Lets every other request in flight run one step before the caller continues.
+     *
+     * Call it right after prefetching what the caller reads next.
+     */
+    auto yield() {
+        struct Awaiter {
+            AsyncScheduler* scheduler;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->ready_.push_back(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{this};
+    }
+
+    /**
+     * @brief Prefetches a node's ID and liveness flag, and with `fingers` its finger table and links.
+     */
+    static void prefetch(const Node* node, bool fingers);
+
+    /**
+     * @brief Queues a task; `done(result)` is called when it finishes.
+     */
+    template <typename T, typename F>
+    void spawn(Task<T> task, F done) {
+        pending_.push_back(drive(std::move(task), std::move(done)).handle);
+    }
+
+    /**
+     * @brief Queues a task whose result is not needed.
+     */
+    template <typename T>
+    void spawn(Task<T> task) {
+        if constexpr (std::is_void_v<T>) {
+            spawn(std::move(task), [] {});
+        } else {
+            spawn(std::move(task), [](T&&) {});
+        }
+    }
+
+    /**
+     * @brief Queues a lookup; the future is ready once run() has processed it.
+     */
+    std::future<LookupResult> submitLookup(Node* origin, NodeId key);
+
+    /**
+     * @brief Queues an insert; the future is ready once run() has processed it.
+     */
+    std::future<Node*> submitInsert(Node* origin, NodeId key, Value value);
+
+    /**
+     * @brief Runs queued requests until all have finished.
+     * @return The number of requests finished by this call.
+     */
+    size_t run();
+
+    /**
+     * @brief Requests queued or running.
+     */
+    size_t outstanding() const { return pending_.size() + active_; }
+
+private:
+    // Top-level coroutine: runs a task to completion, reports, then frees itself
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() {
+                return Detached{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+        std::coroutine_handle<> handle;
+    };
+
+    template <typename T, typename F>
+    Detached drive(Task<T> task, F done) {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            done();
+        } else {
+            done(co_await task);
+        }
+        active_--;
+        completed_++;
+    }
+
+    size_t window_;
+    size_t active_;                               ///< Requests started and not finished
+    size_t completed_;                            ///< Requests finished so far
+    std::deque<std::coroutine_handle<>> pending_; ///< Requests not started yet
+    std::deque<std::coroutine_handle<>> ready_;   ///< Suspended requests, resumed in FIFO order
+};
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // ASYNC_LOOKUP_H
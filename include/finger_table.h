@@ -1,11 +1,15 @@
 #ifndef FINGER_TABLE_H
 #define FINGER_TABLE_H
 
-#include <vector>
+#include <stdint.h>
+#include "identifier.h"
 
 // Forward declare Node to avoid circular dependency
 class Node;
 
+typedef uint32_t NodeHandle;                        ///< Index of a node in its NodePool
+static const NodeHandle kNullHandle = 0xFFFFFFFFu;  ///< Handle that refers to no node
+
 class FingerTable {
 public:
     explicit FingerTable(Node* owner);
@@ -15,11 +19,37 @@ public:
      */
     Node* get(int i) const;
 
+    /**
+     * @brief Get the handle stored at index i (kNullHandle if unset).
+     */
+    NodeHandle getHandle(int i) const {
+        return (i >= 1 && i <= BITLENGTH) ? fingers_[i] : kNullHandle;
+    }
+
+    /**
+     * @brief Get the cached ID of the finger at index i.
+     */
+    const NodeId& getId(int i) const { return ids_[i]; }
+
     /**
      * @brief Set the finger entry at index i.
      */
     void set(int i, Node* node);
 
+    /**
+     * @brief Set entry i from a handle and the ID of the node it refers to (kNullHandle clears it).
+     */
+    void set(int i, NodeHandle handle, const NodeId& id);
+
+    /**
+     * @brief Index of the highest finger whose ID lies in (ownerId, key), or 0 if none.
+     *
+     * Works on the cached IDs only, so no finger node is touched. For native
+     * identifier widths the scan is a branchless max-reduction over all
+     * entries that the compiler can vectorize.
+     */
+    int closestPreceding(const NodeId& ownerId, const NodeId& key) const;
+
     /**
      * @brief Initialize finger table based on the node's position.
      */
@@ -31,8 +61,11 @@ public:
     void prettyPrint();
 
 private:
-    Node* owner_;                   // The node that owns this finger table
-    std::vector<Node*> fingers_;    // Stores pointers to nodes for routing
+    // Structure of arrays: the routing kernel only reads ids_, resolving a
+    // handle happens once for the chosen entry. Index 0 is unused.
+    Node* owner_;                           // The node that owns this finger table
+    NodeId ids_[BITLENGTH + 1];             // Cached IDs of the finger nodes (owner's ID when unset)
+    NodeHandle fingers_[BITLENGTH + 1];     // Pool handles of the finger nodes
 };
 
 #endif  // FINGER_TABLE_H
@@ -0,0 +1,229 @@
+#ifndef IDENTIFIER_H
+#define IDENTIFIER_H
+
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+
+// Chord ring size is 2^BITLENGTH. Override at compile time (e.g. -DBITLENGTH=64);
+// supported widths are 1..64 and 160 (SHA-1 sized identifiers).
+#ifndef BITLENGTH
+#define BITLENGTH 8
+#endif
+
+/**
+ * @class Uint160
+ * @brief Fixed-width 160-bit unsigned integer with wrap-around arithmetic.
+ *
+ * Only the operations the ring needs are provided: add/sub mod 2^160,
+ * comparison, power-of-two construction and decimal printing.
+ */
+class Uint160 {
+public:
+    Uint160() : w_{0, 0, 0, 0, 0} {}
+    Uint160(uint64_t v) : w_{(uint32_t)v, (uint32_t)(v >> 32), 0, 0, 0} {}
+
+    /**
+     * @brief Builds 2^k for 0 <= k < 160.
+     */
+    static Uint160 pow2(int k) {
+        Uint160 r;
+        r.w_[k / 32] = (uint32_t)1 << (k % 32);
+        return r;
+    }
+
+    /**
+     * @brief Builds a value from 20 big-endian bytes (e.g. a SHA-1 digest).
+     */
+    static Uint160 fromBytes(const uint8_t* bytes) {
+        Uint160 r;
+        for (int i = 0; i < 5; ++i) {
+            const uint8_t* p = bytes + 4 * (4 - i);
+            r.w_[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                      ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+        }
+        return r;
+    }
+
+    /**
+     * @brief Returns 32-bit limb i (limb 0 is least significant).
+     */
+    uint32_t limb(int i) const { return w_[i]; }
+
+    Uint160 operator+(const Uint160& o) const {
+        Uint160 r;
+        uint64_t carry = 0;
+        for (int i = 0; i < 5; ++i) {
+            uint64_t s = (uint64_t)w_[i] + o.w_[i] + carry;
+            r.w_[i] = (uint32_t)s;
+            carry = s >> 32;
+        }
+        return r;
+    }
+
+    Uint160 operator-(const Uint160& o) const {
+        Uint160 r;
+        uint64_t borrow = 0;
+        for (int i = 0; i < 5; ++i) {
+            uint64_t d = (uint64_t)w_[i] - o.w_[i] - borrow;
+            r.w_[i] = (uint32_t)d;
+            borrow = (d >> 32) & 1;
+        }
+        return r;
+    }
+
+    bool operator==(const Uint160& o) const {
+        for (int i = 0; i < 5; ++i) {
+            if (w_[i] != o.w_[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const Uint160& o) const { return !(*this == o); }
+
+    bool operator<(const Uint160& o) const {
+        for (int i = 4; i >= 0; --i) {
+            if (w_[i] != o.w_[i]) return w_[i] < o.w_[i];
+        }
+        return false;
+    }
+    bool operator>(const Uint160& o) const { return o < *this; }
+    bool operator<=(const Uint160& o) const { return !(o < *this); }
+    bool operator>=(const Uint160& o) const { return !(*this < o); }
+
+    /**
+     * @brief Decimal representation (used for printing only).
+     */
+    std::string toString() const {
+        Uint160 v = *this;
+        std::string digits;
+        do {
+            uint64_t rem = 0;
+            for (int i = 4; i >= 0; --i) {
+                uint64_t cur = (rem << 32) | v.w_[i];
+                v.w_[i] = (uint32_t)(cur / 10);
+                rem = cur % 10;
+            }
+            digits.insert(digits.begin(), (char)('0' + rem));
+        } while (v != Uint160());
+        return digits;
+    }
+
+private:
+    uint32_t w_[5];  ///< Little-endian 32-bit limbs
+};
+
+/**
+ * @brief Smallest native unsigned word able to hold a Bits-wide identifier.
+ */
+template <int Bits>
+struct IdWord {
+    static_assert(Bits >= 1 && Bits <= 64, "BITLENGTH must be in 1..64 or exactly 160");
+    typedef typename std::conditional<Bits <= 8, uint8_t,
+            typename std::conditional<Bits <= 16, uint16_t,
+            typename std::conditional<Bits <= 32, uint32_t, uint64_t>::type>::type>::type type;
+};
+
+/**
+ * @brief Ring arithmetic for identifiers that fit a native word.
+ *
+ * When Bits equals the word width (8, 16, 32, 64) the mask is all ones and
+ * the compiler drops it, so add/sub are a single wrapping instruction.
+ */
+template <int Bits, typename Word>
+struct NativeIdSpace {
+    typedef Word id_type;
+    static const int bits = Bits;
+
+    static id_type mask() {
+        return Bits == 8 * (int)sizeof(Word) ? (id_type)~(id_type)0
+                                             : (id_type)(((id_type)1 << (Bits % (8 * sizeof(Word)))) - 1);
+    }
+
+    static id_type add(id_type a, id_type b) { return (id_type)((a + b) & mask()); }
+    static id_type sub(id_type a, id_type b) { return (id_type)((a - b) & mask()); }
+    static id_type pow2(int k) { return (id_type)((id_type)1 << k); }
+
+    static std::string toString(id_type x) { return std::to_string((unsigned long long)x); }
+
+    static std::string ringSizeString() {
+        return Bits < 64 ? std::to_string(1ull << (Bits % 64)) : "2^64";
+    }
+};
+
+/**
+ * @brief Ring arithmetic for 160-bit (SHA-1 sized) identifiers.
+ */
+struct WideIdSpace {
+    typedef Uint160 id_type;
+    static const int bits = 160;
+
+    static id_type add(const id_type& a, const id_type& b) { return a + b; }
+    static id_type sub(const id_type& a, const id_type& b) { return a - b; }
+    static id_type pow2(int k) { return Uint160::pow2(k); }
+
+    static std::string toString(const id_type& x) { return x.toString(); }
+    static std::string ringSizeString() { return "2^160"; }
+};
+
+/**
+ * @brief Identifier space of a Chord ring with 2^Bits positions.
+ *
+ * Provides the identifier type plus the modular operations every ring
+ * computation goes through: distance, finger starts and interval tests.
+ */
+template <int Bits>
+struct IdSpace : NativeIdSpace<Bits, typename IdWord<Bits>::type> {
+    typedef NativeIdSpace<Bits, typename IdWord<Bits>::type> Base;
+    typedef typename Base::id_type id_type;
+
+    /**
+     * @brief Start of finger i (1-based): (id + 2^(i-1)) mod 2^Bits.
+     */
+    static id_type fingerStart(id_type id, int i) { return Base::add(id, Base::pow2(i - 1)); }
+
+    /**
+     * @brief Clockwise distance from `from` to `to`.
+     */
+    static id_type distance(id_type from, id_type to) { return Base::sub(to, from); }
+
+    /**
+     * @brief Checks if x lies in the ring interval between start and end.
+     */
+    static bool inInterval(id_type x, id_type start, id_type end,
+                           bool inclusiveStart, bool inclusiveEnd) {
+        if (start == end) {
+            return inclusiveStart || inclusiveEnd;
+        }
+        if (x == start) return inclusiveStart;
+        if (x == end) return inclusiveEnd;
+        return distance(start, x) < distance(start, end);
+    }
+};
+
+template <>
+struct IdSpace<160> : WideIdSpace {
+    static id_type fingerStart(const id_type& id, int i) { return add(id, pow2(i - 1)); }
+    static id_type distance(const id_type& from, const id_type& to) { return sub(to, from); }
+
+    static bool inInterval(const id_type& x, const id_type& start, const id_type& end,
+                           bool inclusiveStart, bool inclusiveEnd) {
+        if (start == end) {
+            return inclusiveStart || inclusiveEnd;
+        }
+        if (x == start) return inclusiveStart;
+        if (x == end) return inclusiveEnd;
+        return distance(start, x) < distance(start, end);
+    }
+};
+
+typedef IdSpace<BITLENGTH> ChordSpace;   ///< Identifier space selected at compile time
+typedef ChordSpace::id_type NodeId;      ///< Node IDs and keys on the ring
+
+/**
+ * @brief Printable form of an identifier.
+ */
+inline std::string idToString(const NodeId& id) {
+    return ChordSpace::toString(id);
+}
+
+#endif  // IDENTIFIER_H
@@ -0,0 +1,71 @@
+#ifndef KEY_HASH_H
+#define KEY_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "identifier.h"
+#include "value.h"
+
+/**
+ * @brief Hash function that maps application keys onto the ring.
+ */
+enum class KeyHash {
+    Sha1,    ///< SHA-1, as in the Chord paper (consistent with real deployments)
+    XXH64    ///< xxHash64, much faster; for simulations
+};
+
+/**
+ * @brief SHA-1 digest of a byte string.
+ * @param digest Receives the 20-byte digest.
+ */
+void sha1(const void* data, size_t size, uint8_t digest[20]);
+
+/**
+ * @brief xxHash64 of a byte string.
+ */
+uint64_t xxh64(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * @brief Maps a byte-string key to its ring identifier.
+ *
+ * The identifier is the top BITLENGTH bits of the hash, read big-endian
+ * (the whole SHA-1 digest for 160-bit rings; three seeded xxHash64 values
+ * for XXH64 on 160-bit rings).
+ */
+NodeId hashKey(const void* data, size_t size, KeyHash hash = KeyHash::XXH64);
+
+/**
+ * @brief Maps a string key to its ring identifier (see the byte-string overload).
+ */
+inline NodeId hashKey(const std::string& key, KeyHash hash = KeyHash::XXH64) {
+    return hashKey(key.data(), key.size(), hash);
+}
+
+/**
+ * @brief Maps many keys to ring identifiers at once; same results as hashKey().
+ *
+ * SHA-1 runs a multi-buffer kernel: keys with the same number of 64-byte
+ * blocks are hashed eight at a time, one per vector lane (keys longer than
+ * four blocks are hashed one by one). xxHash64 is hashed key by key; its
+ * 64-bit multiplies do not vectorize, but the independent keys overlap in
+ * the pipeline.
+ * @param out Receives keys.size() identifiers.
+ */
+void hashKeys(const std::vector<std::string>& keys, NodeId* out, KeyHash hash = KeyHash::XXH64);
+
+/**
+ * @brief Maps many keys to ring identifiers at once (see above).
+ */
+std::vector<NodeId> hashKeys(const std::vector<std::string>& keys, KeyHash hash = KeyHash::XXH64);
+
+/**
+ * @brief Hashes the keys of string-keyed items for Node::insertBatch or Ring::bootstrap.
+ * @param items Key-value pairs; the values are moved into the result.
+ */
+std::vector<std::pair<NodeId, Value>> hashItems(std::vector<std::pair<std::string, Value>> items,
+                                                KeyHash hash = KeyHash::XXH64);
+
+#endif  // KEY_HASH_H
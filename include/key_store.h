@@ -0,0 +1,571 @@
+#ifndef KEY_STORE_H
+#define KEY_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+#include "identifier.h"
+
+// Local storage backend used by every Node. Override at compile time, e.g.
+// -DKEY_STORE=KEY_STORE_HASH. All backends expose the same interface.
+#define KEY_STORE_MAP  1   // std::map (one heap node per key)
+#define KEY_STORE_FLAT 2   // Sorted key/value vectors
+#define KEY_STORE_HASH 3   // Open addressing with linear probing
+
+#ifndef KEY_STORE
+#define KEY_STORE KEY_STORE_FLAT
+#endif
+
+/**
+ * @brief 64-bit finalizer (MurmurHash3 fmix64) used to spread identifiers.
+ */
+inline uint64_t mixId(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+inline uint64_t hashId(const Uint160& x) {
+    uint64_t lo = ((uint64_t)x.limb(1) << 32) | x.limb(0);
+    uint64_t hi = ((uint64_t)x.limb(3) << 32) | x.limb(2);
+    return mixId(lo ^ mixId(hi ^ x.limb(4)));
+}
+
+template <typename T>
+inline uint64_t hashId(T x) {
+    return mixId((uint64_t)x);
+}
+
+/**
+ * @class MapKeyStore
+ * @brief Ordered std::map backend; the original layout, kept as a baseline.
+ */
+template <typename V>
+class MapKeyStore {
+public:
+    typedef std::pair<NodeId, V> Entry;
+
+    V* find(const NodeId& key) {
+        auto it = map_.find(key);
+        return it == map_.end() ? nullptr : &it->second;
+    }
+    const V* find(const NodeId& key) const {
+        auto it = map_.find(key);
+        return it == map_.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * @brief Inserts the key or overwrites its value.
+     */
+    void put(const NodeId& key, V value) { map_[key] = std::move(value); }
+
+    bool erase(const NodeId& key) { return map_.erase(key) > 0; }
+
+    size_t size() const { return map_.size(); }
+    bool empty() const { return map_.empty(); }
+    void clear() { map_.clear(); }
+
+    /**
+     * @brief Visits every entry in ascending key order.
+     */
+    template <typename F>
+    void forEach(F f) const {
+        for (const auto& kv : map_) f(kv.first, kv.second);
+    }
+
+    /**
+     * @brief Visits the keys in the ring interval (a, b] in ring order starting
+     *        after a, without removing them (a == b selects the whole ring).
+     * @param f Called as f(key, value); returning false stops the walk.
+     * @return False if f stopped the walk.
+     */
+    template <typename F>
+    bool forEachInInterval(const NodeId& a, const NodeId& b, F f) const {
+        if (a < b) return visitRange(map_.upper_bound(a), map_.upper_bound(b), f);
+        return visitRange(map_.upper_bound(a), map_.end(), f) &&
+               visitRange(map_.begin(), map_.upper_bound(b), f);
+    }
+
+    /**
+     * @brief Removes every key in the ring interval (a, b] and appends it to `out`
+     *        in ring order starting after a. a == b selects the whole ring.
+     */
+    void extractInterval(const NodeId& a, const NodeId& b, std::vector<Entry>& out) {
+        if (a == b) {
+            extractRange(map_.upper_bound(a), map_.end(), out);
+            extractRange(map_.begin(), map_.upper_bound(b), out);
+        } else if (a < b) {
+            extractRange(map_.upper_bound(a), map_.upper_bound(b), out);
+        } else {
+            extractRange(map_.upper_bound(a), map_.end(), out);
+            extractRange(map_.begin(), map_.upper_bound(b), out);
+        }
+    }
+
+    /**
+     * @brief Moves the first `limit` keys of the ring interval (a, b], in ring
+     *        order after a, into `dest` (a == b selects the whole ring).
+     *
+     * Map nodes are spliced over (extract + hinted insert), so nothing is
+     * allocated or copied and the cost follows the keys moved. Keys `dest`
+     * already holds keep its value; the moved copy is dropped.
+     * @return The number of keys taken out of this store.
+     */
+    size_t moveInterval(const NodeId& a, const NodeId& b, MapKeyStore& dest, size_t limit = (size_t)-1) {
+        if (a < b) return moveRange(map_.upper_bound(a), map_.upper_bound(b), dest, limit);
+        size_t moved = moveRange(map_.upper_bound(a), map_.end(), dest, limit);
+        return moved + moveRange(map_.begin(), map_.upper_bound(b), dest, limit - moved);
+    }
+
+    /**
+     * @brief Adds the entries [first, last), given in ring order as
+     *        extractInterval() produces them, moving their values in.
+     *
+     * Keys this store already holds keep its value. Each entry is inserted
+     * right after the previous one, so the cost follows the entries added.
+     */
+    template <typename It>
+    void insertRun(It first, It last) {
+        auto hint = map_.end();
+        for (; first != last; ++first) {
+            hint = std::next(map_.emplace_hint(hint, first->first, std::move(first->second)));
+        }
+    }
+
+private:
+    typedef typename std::map<NodeId, V>::iterator Iter;
+    typedef typename std::map<NodeId, V>::const_iterator ConstIter;
+
+    template <typename F>
+    static bool visitRange(ConstIter first, ConstIter last, F& f) {
+        for (ConstIter it = first; it != last; ++it) {
+            if (!f(it->first, it->second)) return false;
+        }
+        return true;
+    }
+
+    void extractRange(Iter first, Iter last, std::vector<Entry>& out) {
+        for (Iter it = first; it != last; ++it) {
+            out.emplace_back(it->first, std::move(it->second));
+        }
+        map_.erase(first, last);
+    }
+
+    size_t moveRange(Iter first, Iter last, MapKeyStore& dest, size_t limit) {
+        size_t moved = 0;
+        auto hint = dest.map_.end();
+        while (first != last && moved < limit) {
+            Iter next = std::next(first);
+            // Ascending keys: each one goes right after the previous one
+            hint = std::next(dest.map_.insert(hint, map_.extract(first)));
+            first = next;
+            moved++;
+        }
+        return moved;
+    }
+
+    std::map<NodeId, V> map_;
+};
+
+/**
+ * @class FlatKeyStore
+ * @brief Sorted flat vectors: keys and values stored contiguously, found by binary search.
+ *
+ * Lookups touch a single cache-dense key array; interval extraction is two
+ * binary searches plus one contiguous erase.
+ */
+template <typename V>
+class FlatKeyStore {
+public:
+    typedef std::pair<NodeId, V> Entry;
+
+    V* find(const NodeId& key) {
+        size_t i = lowerBound(key);
+        return (i < keys_.size() && keys_[i] == key) ? &values_[i] : nullptr;
+    }
+    const V* find(const NodeId& key) const {
+        size_t i = lowerBound(key);
+        return (i < keys_.size() && keys_[i] == key) ? &values_[i] : nullptr;
+    }
+
+    void put(const NodeId& key, V value) {
+        size_t i = lowerBound(key);
+        if (i < keys_.size() && keys_[i] == key) {
+            values_[i] = std::move(value);
+            return;
+        }
+        keys_.insert(keys_.begin() + i, key);
+        values_.insert(values_.begin() + i, std::move(value));
+    }
+
+    bool erase(const NodeId& key) {
+        size_t i = lowerBound(key);
+        if (i == keys_.size() || keys_[i] != key) return false;
+        keys_.erase(keys_.begin() + i);
+        values_.erase(values_.begin() + i);
+        return true;
+    }
+
+    size_t size() const { return keys_.size(); }
+    bool empty() const { return keys_.empty(); }
+    void clear() {
+        keys_.clear();
+        values_.clear();
+    }
+
+    template <typename F>
+    void forEach(F f) const {
+        for (size_t i = 0; i < keys_.size(); ++i) f(keys_[i], values_[i]);
+    }
+
+    template <typename F>
+    bool forEachInInterval(const NodeId& a, const NodeId& b, F f) const {
+        size_t afterA = upperBound(a);
+        size_t throughB = upperBound(b);
+        if (a < b) return visitRange(afterA, throughB, f);
+        return visitRange(afterA, keys_.size(), f) && visitRange(0, std::min(throughB, afterA), f);
+    }
+
+    void extractInterval(const NodeId& a, const NodeId& b, std::vector<Entry>& out) {
+        size_t afterA = upperBound(a);
+        size_t throughB = upperBound(b);
+        if (a < b) {
+            extractRange(afterA, throughB, out);
+        } else {
+            // Wrapping (or whole-ring) interval: tail after a, then head through b.
+            // Taking the tail first keeps indices of the head valid.
+            extractRange(afterA, keys_.size(), out);
+            extractRange(0, std::min(throughB, afterA), out);
+        }
+    }
+
+    /**
+     * @brief Moves the first `limit` keys of the ring interval (a, b], in ring
+     *        order after a, into `dest` (a == b selects the whole ring).
+     *
+     * The keys form at most two contiguous blocks: each is found with two
+     * binary searches, inserted into `dest` in one piece (merged if `dest`
+     * has keys inside its span) and erased in one piece, so beyond shifting
+     * the vectors' tails the cost follows the keys moved. Keys `dest`
+     * already holds keep its value.
+     * @return The number of keys taken out of this store.
+     */
+    size_t moveInterval(const NodeId& a, const NodeId& b, FlatKeyStore& dest, size_t limit = (size_t)-1) {
+        size_t afterA = upperBound(a);
+        size_t throughB = upperBound(b);
+        if (a < b) return moveRange(afterA, throughB, dest, limit);
+        // Tail first, which keeps the head's indices valid
+        size_t moved = moveRange(afterA, keys_.size(), dest, limit);
+        return moved + moveRange(0, std::min(throughB, afterA), dest, limit - moved);
+    }
+
+    /**
+     * @brief Adds the entries [first, last), given in ring order as
+     *        extractInterval() produces them, moving their values in.
+     *
+     * Ring order is ascending with at most one wrap past the top of the
+     * ring, so the entries form at most two blocks, each inserted in one
+     * piece (see moveInterval()). Keys this store already holds keep its value.
+     */
+    template <typename It>
+    void insertRun(It first, It last) {
+        std::vector<NodeId> keys;
+        std::vector<V> values;
+        while (first != last) {
+            keys.clear();
+            values.clear();
+            do {
+                keys.push_back(first->first);
+                values.push_back(std::move(first->second));
+                ++first;
+            } while (first != last && keys.back() < first->first);
+            insertBlock(keys.begin(), keys.end(), values.begin());
+        }
+    }
+
+private:
+    size_t lowerBound(const NodeId& key) const {
+        return std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+    }
+    size_t upperBound(const NodeId& key) const {
+        return std::upper_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+    }
+
+    template <typename F>
+    bool visitRange(size_t first, size_t last, F& f) const {
+        for (size_t i = first; i < last; ++i) {
+            if (!f(keys_[i], values_[i])) return false;
+        }
+        return true;
+    }
+
+    void extractRange(size_t first, size_t last, std::vector<Entry>& out) {
+        if (first >= last) return;
+        out.reserve(out.size() + (last - first));
+        for (size_t i = first; i < last; ++i) {
+            out.emplace_back(keys_[i], std::move(values_[i]));
+        }
+        keys_.erase(keys_.begin() + first, keys_.begin() + last);
+        values_.erase(values_.begin() + first, values_.begin() + last);
+    }
+
+    size_t moveRange(size_t first, size_t last, FlatKeyStore& dest, size_t limit) {
+        if (first >= last || limit == 0) return 0;
+        last = first + std::min(last - first, limit);
+        dest.insertBlock(keys_.begin() + first, keys_.begin() + last, values_.begin() + first);
+        keys_.erase(keys_.begin() + first, keys_.begin() + last);
+        values_.erase(values_.begin() + first, values_.begin() + last);
+        return last - first;
+    }
+
+    // Adds the sorted keys [keyFirst, keyLast) and their values, keeping existing keys
+    template <typename KeyIt, typename ValueIt>
+    void insertBlock(KeyIt keyFirst, KeyIt keyLast, ValueIt valueFirst) {
+        size_t n = keyLast - keyFirst;
+        size_t pos = lowerBound(*keyFirst);
+        if (pos == keys_.size() || *(keyLast - 1) < keys_[pos]) {
+            // No existing key inside the block's span: one block insert
+            keys_.insert(keys_.begin() + pos, keyFirst, keyLast);
+            values_.insert(values_.begin() + pos, std::make_move_iterator(valueFirst),
+                           std::make_move_iterator(valueFirst + n));
+            return;
+        }
+        std::vector<NodeId> keys;
+        std::vector<V> values;
+        keys.reserve(keys_.size() + n);
+        values.reserve(keys_.size() + n);
+        size_t i = 0, j = 0;
+        while (i < keys_.size() || j < n) {
+            if (j == n || (i < keys_.size() && !(keyFirst[j] < keys_[i]))) {
+                if (j < n && keyFirst[j] == keys_[i]) j++;   // Ours wins
+                keys.push_back(keys_[i]);
+                values.push_back(std::move(values_[i++]));
+            } else {
+                keys.push_back(keyFirst[j]);
+                values.push_back(std::move(valueFirst[j++]));
+            }
+        }
+        keys_.swap(keys);
+        values_.swap(values);
+    }
+
+    std::vector<NodeId> keys_;   ///< Sorted keys
+    std::vector<V> values_;      ///< values_[i] belongs to keys_[i]
+};
+
+/**
+ * @class HashKeyStore
+ * @brief Open-addressing hash table (linear probing, backward-shift deletion).
+ *
+ * Point operations are O(1) with no per-key allocation. Interval extraction
+ * has to scan every slot, so its cost follows the table capacity.
+ */
+template <typename V>
+class HashKeyStore {
+public:
+    typedef std::pair<NodeId, V> Entry;
+
+    HashKeyStore() : size_(0) {}
+
+    V* find(const NodeId& key) {
+        size_t i = findSlot(key);
+        return i == npos ? nullptr : &slots_[i].value;
+    }
+    const V* find(const NodeId& key) const {
+        size_t i = findSlot(key);
+        return i == npos ? nullptr : &slots_[i].value;
+    }
+
+    void put(const NodeId& key, V value) {
+        if ((size_ + 1) * 4 > used_.size() * 3) grow();
+        size_t i = probeStart(key);
+        while (used_[i]) {
+            if (slots_[i].key == key) {
+                slots_[i].value = std::move(value);
+                return;
+            }
+            i = (i + 1) & (used_.size() - 1);
+        }
+        used_[i] = 1;
+        slots_[i].key = key;
+        slots_[i].value = std::move(value);
+        ++size_;
+    }
+
+    bool erase(const NodeId& key) {
+        size_t i = findSlot(key);
+        if (i == npos) return false;
+        eraseSlot(i);
+        return true;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear() {
+        slots_.clear();
+        used_.clear();
+        size_ = 0;
+    }
+
+    /**
+     * @brief Visits every entry in unspecified order.
+     */
+    template <typename F>
+    void forEach(F f) const {
+        for (size_t i = 0; i < used_.size(); ++i) {
+            if (used_[i]) f(slots_[i].key, slots_[i].value);
+        }
+    }
+
+    /**
+     * @brief Visits the keys in (a, b] in ring order; scans and sorts the matching slots.
+     */
+    template <typename F>
+    bool forEachInInterval(const NodeId& a, const NodeId& b, F f) const {
+        std::vector<size_t> hits;
+        for (size_t i = 0; i < used_.size(); ++i) {
+            if (used_[i] && ChordSpace::inInterval(slots_[i].key, a, b, false, true)) hits.push_back(i);
+        }
+        const NodeId afterA = ChordSpace::add(a, NodeId(1));   // a itself comes last on a whole-ring walk
+        std::sort(hits.begin(), hits.end(), [&](size_t x, size_t y) {
+            return ChordSpace::distance(afterA, slots_[x].key) < ChordSpace::distance(afterA, slots_[y].key);
+        });
+        for (size_t i : hits) {
+            if (!f(slots_[i].key, slots_[i].value)) return false;
+        }
+        return true;
+    }
+
+    void extractInterval(const NodeId& a, const NodeId& b, std::vector<Entry>& out) {
+        size_t first = out.size();
+        for (size_t i = 0; i < used_.size();) {
+            if (used_[i] && ChordSpace::inInterval(slots_[i].key, a, b, false, true)) {
+                out.emplace_back(slots_[i].key, std::move(slots_[i].value));
+                // Backward shift may pull a later entry into slot i; re-check it.
+                eraseSlot(i);
+            } else {
+                ++i;
+            }
+        }
+        const NodeId afterA = ChordSpace::add(a, NodeId(1));   // a itself comes last on a whole-ring extract
+        std::sort(out.begin() + first, out.end(), [&](const Entry& x, const Entry& y) {
+            return ChordSpace::distance(afterA, x.first) < ChordSpace::distance(afterA, y.first);
+        });
+    }
+
+    /**
+     * @brief Moves the first `limit` keys of the ring interval (a, b], in ring
+     *        order after a, into `dest` (a == b selects the whole ring).
+     *
+     * Entries go straight from slot to slot, but finding them still scans
+     * every slot, so the cost follows the table capacity. Keys `dest`
+     * already holds keep its value.
+     * @return The number of keys taken out of this store.
+     */
+    size_t moveInterval(const NodeId& a, const NodeId& b, HashKeyStore& dest, size_t limit = (size_t)-1) {
+        if (limit == 0) return 0;
+        std::vector<NodeId> chosen;
+        for (size_t i = 0; i < used_.size(); ++i) {
+            if (used_[i] && ChordSpace::inInterval(slots_[i].key, a, b, false, true)) chosen.push_back(slots_[i].key);
+        }
+        if (chosen.size() > limit) {
+            const NodeId afterA = ChordSpace::add(a, NodeId(1));   // a itself comes last on a whole-ring walk
+            std::nth_element(chosen.begin(), chosen.begin() + limit, chosen.end(),
+                             [&](const NodeId& x, const NodeId& y) {
+                                 return ChordSpace::distance(afterA, x) < ChordSpace::distance(afterA, y);
+                             });
+            chosen.resize(limit);
+        }
+        for (const NodeId& key : chosen) {
+            size_t i = findSlot(key);
+            if (!dest.find(key)) dest.put(key, std::move(slots_[i].value));
+            eraseSlot(i);
+        }
+        return chosen.size();
+    }
+
+    /**
+     * @brief Adds the entries [first, last), moving their values in; keys this
+     *        store already holds keep its value.
+     */
+    template <typename It>
+    void insertRun(It first, It last) {
+        for (; first != last; ++first) {
+            if (!find(first->first)) put(first->first, std::move(first->second));
+        }
+    }
+
+private:
+    struct Slot {
+        NodeId key = NodeId();
+        V value = V();
+    };
+
+    static const size_t npos = (size_t)-1;
+
+    size_t probeStart(const NodeId& key) const {
+        return (size_t)hashId(key) & (used_.size() - 1);
+    }
+
+    size_t findSlot(const NodeId& key) const {
+        if (used_.empty()) return npos;
+        for (size_t i = probeStart(key); used_[i]; i = (i + 1) & (used_.size() - 1)) {
+            if (slots_[i].key == key) return i;
+        }
+        return npos;
+    }
+
+    void eraseSlot(size_t hole) {
+        size_t mask = used_.size() - 1;
+        size_t i = hole;
+        while (true) {
+            i = (i + 1) & mask;
+            if (!used_[i]) break;
+            size_t home = probeStart(slots_[i].key);
+            // Move slot i into the hole unless its home lies cyclically in (hole, i].
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots_[hole] = std::move(slots_[i]);
+                hole = i;
+            }
+        }
+        used_[hole] = 0;
+        slots_[hole] = Slot();
+        --size_;
+    }
+
+    void grow() {
+        std::vector<Slot> oldSlots;
+        std::vector<uint8_t> oldUsed;
+        oldSlots.swap(slots_);
+        oldUsed.swap(used_);
+
+        size_t capacity = oldUsed.empty() ? 16 : oldUsed.size() * 2;
+        slots_.resize(capacity);
+        used_.assign(capacity, 0);
+        size_ = 0;
+        for (size_t i = 0; i < oldUsed.size(); ++i) {
+            if (oldUsed[i]) put(oldSlots[i].key, std::move(oldSlots[i].value));
+        }
+    }
+
+    std::vector<Slot> slots_;     ///< Key/value slots, capacity is a power of two
+    std::vector<uint8_t> used_;   ///< Occupancy flag per slot
+    size_t size_;                 ///< Number of occupied slots
+};
+
+#if KEY_STORE == KEY_STORE_MAP
+template <typename V> using KeyStore = MapKeyStore<V>;
+#elif KEY_STORE == KEY_STORE_HASH
+template <typename V> using KeyStore = HashKeyStore<V>;
+#else
+template <typename V> using KeyStore = FlatKeyStore<V>;
+#endif
+
+#endif  // KEY_STORE_H
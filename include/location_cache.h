@@ -0,0 +1,106 @@
+#ifndef LOCATION_CACHE_H
+#define LOCATION_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "identifier.h"
+
+class Node;
+
+/**
+ * @struct LocationCacheStats
+ * @brief Counters of a location cache (or the sum over many).
+ */
+struct LocationCacheStats {
+    uint64_t hits = 0;        ///< Lookups answered by a cached, still valid owner
+    uint64_t misses = 0;      ///< Lookups with no cached range covering the key
+    uint64_t stale = 0;       ///< Cached owners that no longer owned the key (evicted, then routed)
+    uint64_t hopsSaved = 0;   ///< Routing hops the hits avoided, by the hops of the lookups that filled them
+
+    /**
+     * @brief Fraction of lookups answered from the cache.
+     */
+    double hitRate() const {
+        uint64_t total = hits + misses + stale;
+        return total ? (double)hits / total : 0.0;
+    }
+
+    LocationCacheStats& operator+=(const LocationCacheStats& other) {
+        hits += other.hits;
+        misses += other.misses;
+        stale += other.stale;
+        hopsSaved += other.hopsSaved;
+        return *this;
+    }
+};
+
+/**
+ * @class LocationCache
+ * @brief Bounded map from key ranges (start, end] to the node owning them, with CLOCK eviction.
+ *
+ * A node remembers the owners its lookups resolved together with the range
+ * the owner was responsible for, so later keys in that range skip routing.
+ * Entries are never trusted blindly: find() hands back a candidate, and the
+ * caller validates it against the owner's current state (still in the ring,
+ * key still in (predecessor, owner]), so joins, leaves and notify() changing
+ * a range only cost one stale probe.
+ *
+ * Ranges are kept in an array sorted by their end, searched with a binary
+ * search; capacities are small, so inserts just shift the array.
+ */
+class LocationCache {
+public:
+    /**
+     * @param capacity Maximum number of cached ranges (at least 1).
+     */
+    explicit LocationCache(size_t capacity);
+
+    /**
+     * @brief Finds the cached range covering `key`.
+     * @param hops Set to the routing hops of the lookup that cached the range.
+     * @return The cached owner, or nullptr if no range covers the key.
+     */
+    Node* find(NodeId key, int& hops);
+
+    /**
+     * @brief Caches `owner` as responsible for (start, end], replacing any range ending at `end`.
+     * @param hops Routing hops the lookup that resolved the owner took.
+     */
+    void insert(NodeId start, NodeId end, Node* owner, int hops);
+
+    /**
+     * @brief Drops the range that covers `key`, if any.
+     */
+    void erase(NodeId key);
+
+    /**
+     * @brief Drops every range (the counters are kept).
+     */
+    void clear();
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return slots_.size(); }
+
+    LocationCacheStats stats;   ///< Updated by the owning node
+
+private:
+    struct Slot {
+        NodeId start;
+        NodeId end;
+        Node* owner;      // nullptr for a free slot
+        uint16_t hops;
+        bool referenced;  // CLOCK bit, set on every hit
+    };
+
+    int indexOf(NodeId key) const;   // Position in index_ of the range covering key, or -1
+    uint32_t evict();                // Frees a slot chosen by the CLOCK hand (cache full)
+
+    std::vector<Slot> slots_;
+    std::vector<std::pair<NodeId, uint32_t>> index_;   ///< (end, slot), sorted by end
+    std::vector<uint32_t> free_;                        ///< Unused slots
+    size_t hand_;                                       ///< CLOCK hand over slots_
+};
+
+#endif  // LOCATION_CACHE_H
@@ -0,0 +1,174 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compile-time log level. Messages above it are removed entirely, arguments
+// included; e.g. -DDHT_LOG_LEVEL=DHT_LOG_LEVEL_OFF strips all protocol logging.
+#define DHT_LOG_LEVEL_OFF   0
+#define DHT_LOG_LEVEL_ERROR 1
+#define DHT_LOG_LEVEL_WARN  2
+#define DHT_LOG_LEVEL_INFO  3   // Protocol events: joins, leaves, stored/migrated keys, lookups
+#define DHT_LOG_LEVEL_DEBUG 4
+
+#ifndef DHT_LOG_LEVEL
+#define DHT_LOG_LEVEL DHT_LOG_LEVEL_INFO
+#endif
+
+enum class LogLevel { Error = DHT_LOG_LEVEL_ERROR, Warn, Info, Debug };
+
+/**
+ * @class LogSink
+ * @brief Destination for formatted log messages.
+ */
+class LogSink {
+public:
+    virtual ~LogSink() {}
+
+    /**
+     * @brief Receives one message (without trailing newline).
+     */
+    virtual void write(LogLevel level, const std::string& message) = 0;
+
+    virtual void flush() {}
+
+    /**
+     * @brief True if messages are dropped anyway, so callers may skip formatting.
+     */
+    virtual bool discards() const { return false; }
+};
+
+/**
+ * @class StdoutSink
+ * @brief Writes each message as a line to std::cout without flushing (the default sink).
+ */
+class StdoutSink : public LogSink {
+public:
+    void write(LogLevel level, const std::string& message) override;
+    void flush() override;
+};
+
+/**
+ * @class NullSink
+ * @brief Drops every message; formatting is skipped as well.
+ */
+class NullSink : public LogSink {
+public:
+    void write(LogLevel, const std::string&) override {}
+    bool discards() const override { return true; }
+};
+
+/**
+ * @class BufferedFileSink
+ * @brief Appends messages to a file through a large in-memory buffer.
+ */
+class BufferedFileSink : public LogSink {
+public:
+    /**
+     * @param path File to write (truncated on open).
+     * @param bufferBytes Bytes collected before each write to the file.
+     */
+    explicit BufferedFileSink(const std::string& path, size_t bufferBytes = 1 << 20);
+    ~BufferedFileSink() override;
+
+    void write(LogLevel level, const std::string& message) override;
+    void flush() override;
+
+    bool isOpen() const { return file_ != nullptr; }
+
+private:
+    void flushLocked();
+
+    std::FILE* file_;
+    std::string buffer_;
+    size_t bufferBytes_;
+    std::mutex mutex_;
+};
+
+/**
+ * @class RingBufferSink
+ * @brief Keeps only the most recent messages in memory.
+ */
+class RingBufferSink : public LogSink {
+public:
+    explicit RingBufferSink(size_t capacity);
+
+    void write(LogLevel level, const std::string& message) override;
+
+    /**
+     * @brief Retained messages, oldest first.
+     */
+    std::vector<std::string> messages() const;
+
+    /**
+     * @brief Messages written in total, including overwritten ones.
+     */
+    size_t totalWritten() const;
+
+private:
+    std::vector<std::string> entries_;
+    size_t next_;
+    size_t total_;
+    mutable std::mutex mutex_;
+};
+
+/**
+ * @class Log
+ * @brief Process-wide sink and runtime level for the DHT_LOG_* macros.
+ */
+class Log {
+public:
+    /**
+     * @brief Routes messages to `sink` (not owned); nullptr restores the stdout sink.
+     */
+    static void setSink(LogSink* sink);
+    static LogSink& sink();
+
+    /**
+     * @brief Runtime threshold, only meaningful below the compile-time DHT_LOG_LEVEL.
+     */
+    static void setLevel(LogLevel level);
+
+    static bool enabled(LogLevel level);
+    static void write(LogLevel level, const std::string& message);
+};
+
+#define DHT_LOG_AT(level, expr)                              \
+    do {                                                     \
+        if (Log::enabled(level)) {                           \
+            std::ostringstream dhtLogStream_;                \
+            dhtLogStream_ << expr;                           \
+            Log::write(level, dhtLogStream_.str());          \
+        }                                                    \
+    } while (0)
+
+#if DHT_LOG_LEVEL >= DHT_LOG_LEVEL_ERROR
+#define DHT_LOG_ERROR(expr) DHT_LOG_AT(LogLevel::Error, expr)
+#else
+#define DHT_LOG_ERROR(expr) do { } while (0)
+#endif
+
+#if DHT_LOG_LEVEL >= DHT_LOG_LEVEL_WARN
+#define DHT_LOG_WARN(expr) DHT_LOG_AT(LogLevel::Warn, expr)
+#else
+#define DHT_LOG_WARN(expr) do { } while (0)
+#endif
+
+#if DHT_LOG_LEVEL >= DHT_LOG_LEVEL_INFO
+#define DHT_LOG_INFO(expr) DHT_LOG_AT(LogLevel::Info, expr)
+#else
+#define DHT_LOG_INFO(expr) do { } while (0)
+#endif
+
+#if DHT_LOG_LEVEL >= DHT_LOG_LEVEL_DEBUG
+#define DHT_LOG_DEBUG(expr) DHT_LOG_AT(LogLevel::Debug, expr)
+#else
+#define DHT_LOG_DEBUG(expr) do { } while (0)
+#endif
+
+#endif  // LOG_H
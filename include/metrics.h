@@ -0,0 +1,177 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "identifier.h"
+
+// Compile-time switch for protocol instrumentation. -DDHT_METRICS=0 removes
+// every counter update, and the per-node counters themselves.
+#ifndef DHT_METRICS
+#define DHT_METRICS 1
+#endif
+
+#if DHT_METRICS
+#define DHT_METRIC(...) do { __VA_ARGS__; } while (0)
+#else
+#define DHT_METRIC(...) do { } while (0)
+#endif
+
+/**
+ * @class Histogram
+ * @brief Counts of non-negative integer samples in 64 log-linear buckets.
+ *
+ * Values below 16 get a bucket each; up to 65535 every power of two is
+ * split into four buckets, and larger values share the last one. So
+ * percentiles are exact for small values such as hops and within 25% for
+ * larger ones; max() is always exact. Recording never allocates.
+ */
+class Histogram {
+public:
+    static const int kBuckets = 64;
+
+    Histogram() { clear(); }
+
+    void record(uint64_t value) {
+        counts_[bucket(value)]++;
+        count_++;
+        sum_ += value;
+        if (value > max_) max_ = value;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t sum() const { return sum_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? (double)sum_ / count_ : 0.0; }
+
+    /**
+     * @brief Upper bound of the bucket holding the p-quantile (p in [0, 1]), capped at max().
+     */
+    uint64_t percentile(double p) const;
+
+    /**
+     * @brief Non-empty buckets as (lowest value, count), in increasing order.
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> buckets() const;
+
+    void clear();
+
+    Histogram& operator+=(const Histogram& other);
+
+    /**
+     * @brief Bucket index of a value.
+     */
+    static int bucket(uint64_t value) {
+        if (value < 16) return (int)value;
+        if (value >= 65536) return kBuckets - 1;
+        int octave = 63 - __builtin_clzll(value);          // 4..15
+        int sub = (int)(value >> (octave - 2)) & 3;         // The two bits below the leading one
+        return 16 + 4 * (octave - 4) + sub;
+    }
+
+    /**
+     * @brief Lowest value falling in bucket b.
+     */
+    static uint64_t bucketLow(int b) {
+        if (b < 16) return (uint64_t)b;
+        int octave = 4 + (b - 16) / 4;
+        return (uint64_t)(4 + (b - 16) % 4) << (octave - 2);
+    }
+
+private:
+    uint64_t counts_[kBuckets];
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t max_;
+};
+
+/**
+ * @struct NodeMetrics
+ * @brief Protocol work done by one node (or summed over many).
+ *
+ * Counters belong to the node that did the work: the origin of a lookup,
+ * the node running stabilize() or fix_fingers(), the receiver of notify()
+ * and the node gaining keys. Only that node updates them, so the parallel
+ * round modes need no synchronisation.
+ */
+struct NodeMetrics {
+    uint64_t lookups = 0;              ///< Routed lookups started here (including fix_fingers() and joins)
+    uint64_t lookupHops = 0;           ///< Forwarding hops of those lookups
+    uint64_t lookupTimeouts = 0;       ///< Failed entries they routed around
+    uint64_t stabilizeCalls = 0;       ///< stabilize() runs (or Parallel round steps)
+    uint64_t stabilizeMessages = 0;    ///< Messages they sent: timed-out successor probe, predecessor query,
+                                       ///< notify, list fetch and replica copies
+    uint64_t successorChanges = 0;     ///< Times stabilization moved the successor pointer
+    uint64_t notifyCalls = 0;          ///< notify() calls received
+    uint64_t predecessorChanges = 0;   ///< Times notify() or stabilization moved the predecessor pointer
+    uint64_t fixFingersCalls = 0;      ///< fix_fingers() runs (or Parallel round steps)
+    uint64_t fingersChanged = 0;       ///< Finger entries that changed, by any repair path
+    uint64_t keysMigratedIn = 0;       ///< Keys received on join, leave or replica promotion
+    uint64_t keysMigratedOut = 0;      ///< Keys handed to another node
+    Histogram hopsPerLookup;
+
+    NodeMetrics& operator+=(const NodeMetrics& other);
+};
+
+/**
+ * @struct RingMetrics
+ * @brief Ring-wide maintenance counters and the histograms of per-round and per-call work.
+ */
+struct RingMetrics {
+    uint64_t stabilizeRounds = 0;
+    uint64_t fixFingersRounds = 0;
+    uint64_t migrations = 0;               ///< Key transfers between nodes
+    Histogram messagesPerStabilizeRound;   ///< Messages sent by all nodes in one round
+    Histogram fingersChangedPerRound;      ///< Finger entries changed by all nodes in one round
+    Histogram fingersChangedPerFix;        ///< Finger entries changed by one fix_fingers()
+    Histogram keysPerMigration;            ///< Keys moved by one transfer
+};
+
+/**
+ * @class Metrics
+ * @brief Process-wide RingMetrics.
+ *
+ * Updated only from the thread driving joins, leaves and maintenance
+ * rounds; the Parallel round modes add their totals after joining their
+ * workers.
+ */
+class Metrics {
+public:
+    static RingMetrics& global();
+    static void reset();
+};
+
+/**
+ * @struct MetricsSnapshot
+ * @brief Copy of every node's counters plus the ring-wide ones, exportable as JSON or CSV.
+ */
+struct MetricsSnapshot {
+    bool enabled = DHT_METRICS != 0;   ///< False if counters were compiled out (everything reads 0)
+    RingMetrics ring;
+    NodeMetrics total;                 ///< Sum over `nodes`
+    struct Entry {
+        NodeId id;
+        bool inRing;
+        NodeMetrics metrics;
+    };
+    std::vector<Entry> nodes;          ///< In handle order
+
+    /**
+     * @brief One JSON object: ring counters and histograms, the totals, then one object per node.
+     * @param perNode Include the per-node objects.
+     */
+    void writeJson(std::ostream& out, bool perNode = true) const;
+
+    /**
+     * @brief Node counters as CSV: a header row, one row per node and a final "total" row.
+     *
+     * The hop histogram appears as count, mean, p50, p99 and max columns;
+     * the ring-wide histograms are only in the JSON.
+     */
+    void writeCsv(std::ostream& out) const;
+};
+
+#endif  // METRICS_H
@@ -2,13 +2,69 @@
 #define NODE_H
 
 #include <stdint.h>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 #include <set>
+#include "identifier.h"
 #include "finger_table.h"
+#include "key_hash.h"
+#include "key_store.h"
+#include "location_cache.h"
+#include "metrics.h"
+#include "value.h"
 
-#define BITLENGTH 8  // Chord ring size is 2^BITLENGTH (Max nodes in the ring: 2^8 = 256)
+// Length r of each node's successor list: the backups used to route around failed successors
+#ifndef SUCCESSOR_LIST_LENGTH
+#define SUCCESSOR_LIST_LENGTH 8
+#endif
+
+// Copies kept of every key: one on its owner, one on each of the owner's next REPLICATION_FACTOR - 1 successors
+#ifndef REPLICATION_FACTOR
+#define REPLICATION_FACTOR 1
+#endif
+
+static_assert(REPLICATION_FACTOR >= 1 && REPLICATION_FACTOR <= SUCCESSOR_LIST_LENGTH + 1,
+              "replicas live on the successor list");
+
+class Node;
+class NodePool;
+
+typedef uint32_t HostId;                        ///< Physical machine running one or more nodes (virtual nodes)
+static const HostId kNoHost = 0xFFFFFFFFu;      ///< "Give the node a host of its own"
+
+/**
+ * @struct LookupResult
+ * @brief Outcome of an iterative lookup.
+ */
+struct LookupResult {
+    Node* node = nullptr;      ///< Node responsible for the key
+    int hops = 0;              ///< Forwarding hops taken from the origin node
+    int timeouts = 0;          ///< Failed fingers or successors routed around (a timeout each in a real network)
+    bool replica = false;      ///< `node` answers from a replica rather than as the key's owner
+    std::vector<Node*> path;   ///< Visited nodes, origin first (only filled when requested)
+};
+
+/**
+ * @brief How Node::rangeQuery() visits the nodes covering a range.
+ */
+enum class ScanMode {
+    Walk,     ///< One node after the other along successor pointers
+    FanOut    ///< Find the covering nodes first, then scan them in parallel
+};
+
+/**
+ * @struct RangeScanStats
+ * @brief Cost and outcome of a range scan.
+ */
+struct RangeScanStats {
+    int hops = 0;            ///< Routing hops to the node responsible for the range start
+    int nodes = 0;           ///< Nodes whose keys were scanned
+    size_t keys = 0;         ///< Keys delivered
+    bool complete = true;    ///< False if the walk met a node with no live successor, or was stopped
+};
 
 /**
  * @class Node
@@ -16,17 +72,16 @@
  */
 class Node {
 public:
-    /**
-     * @brief Constructs a node with a given ID.
-     * @param id Unique identifier of the node in the Chord ring.
-     */
-    Node(uint8_t id);
-
     /**
      * @brief Joins the Chord network.
+     *
+     * The keys in (predecessor, this] are moved over from the successor's
+     * store in one splice, or `migrationChunk` at a time (see
+     * continueMigration()).
      * @param knownNode An existing node in the network. Pass nullptr for the first node.
+     * @param migrationChunk Keys per migration step; 0 moves them all at once.
      */
-    void join(Node* knownNode);
+    void join(Node* knownNode, size_t migrationChunk = 0);
 
     /**
      * @brief Collects all nodes in the network starting from this node.
@@ -35,10 +90,11 @@ public:
     std::vector<Node*> collectAllNodes();
 
     /**
-     * @brief Runs the stabilization protocol on all nodes.
+     * @brief Runs stabilization rounds on all nodes until a round changes nothing.
      * @param nodes Vector of all nodes in the network.
+     * @return The number of rounds that were run.
      */
-    static void stabilizeAll(std::vector<Node*>& nodes);
+    static int stabilizeAll(std::vector<Node*>& nodes);
 
     /**
      * @brief Stabilizes the entire Chord network, ensuring successor and predecessor correctness.
@@ -47,10 +103,37 @@ public:
     static void stabilizeNetwork(Node* startNode);
 
     /**
-     * @brief Fixes the finger tables of all nodes.
+     * @brief Fixes the finger tables of all nodes, stopping once a round changes nothing.
      * @param startNode A node in the network to begin updating finger tables.
+     * @return The number of finger entries that changed.
+     */
+    static int fixAllFingers(Node* startNode);
+
+    /**
+     * @brief Fixes the finger tables of the given nodes, stopping once a round changes nothing.
+     * @param nodes Vector of all nodes in the network.
+     * @return The number of finger entries that changed.
+     */
+    static int fixAllFingers(std::vector<Node*>& nodes);
+
+    /**
+     * @brief Repairs only the finger entries affected by this node's join.
+     *
+     * Entry i of node x must point to this node iff x + 2^(i-1) falls in
+     * (predecessor, this], so for every i only the nodes in
+     * (predecessor - 2^(i-1), this - 2^(i-1)] are visited.
+     * @return The number of finger entries that changed.
+     */
+    int repairFingersAfterJoin();
+
+    /**
+     * @brief Repairs only the finger entries that pointed to this node after it left.
+     *
+     * Call after leave(); the entries covering (predecessor, this] are
+     * redirected to the former successor.
+     * @return The number of finger entries that changed.
      */
-    static void fixAllFingers(Node* startNode);
+    int repairFingersAfterLeave();
 
     /**
      * @brief Prints all stored key-value pairs in the Chord network.
@@ -71,41 +154,194 @@ public:
     static void printRing(Node* startNode);
 
     /**
-     * @brief Deletes all nodes from memory.
-     * @param startNode A node in the network to begin deletion.
+     * @brief Inserts a key-value pair into the Chord ring.
+     * @param key The key to store.
+     * @param value The value associated with the key (moved into the store).
      */
-    static void deleteAllNodes(Node* startNode);
+    void insert(NodeId key, Value value);
 
     /**
-     * @brief Inserts a key-value pair into the Chord ring.
+     * @brief Inserts a key with an integer value, stored as its decimal text.
      * @param key The key to store.
      * @param value The value associated with the key.
      */
-    void insert(uint8_t key, int value);
+    void insert(NodeId key, int value);
 
     /**
-     * @brief Inserts a key with a default "None" value (-1).
+     * @brief Inserts a key with a default "None" value (std::nullopt).
      * @param key The key to store.
      */
-    void insert(uint8_t key);
+    void insert(NodeId key);
+
+    /**
+     * @brief Inserts a value under an arbitrary string key, hashed onto the ring.
+     * @param key The application key; stored under hashKey(key, hash).
+     * @param value The value associated with the key (moved into the store).
+     * @param hash The key hash; every client of a ring must use the same one.
+     */
+    void insert(const std::string& key, Value value, KeyHash hash = KeyHash::XXH64);
+
+    /**
+     * @brief Inserts many key-value pairs, routing keys that share a next hop together.
+     * @param items The key-value pairs to store (values are moved into the ring).
+     */
+    void insertBatch(std::vector<std::pair<NodeId, Value>> items);
+
+    /**
+     * @brief Looks up the value stored for a key.
+     *
+     * With REPLICATION_FACTOR > 1 the value may come from a replica on the
+     * way (see lookup()).
+     * @param key The key to find.
+     * @return The stored value, or nullptr when the key is not in the ring.
+     */
+    const Value* get(NodeId key);
+
+    /**
+     * @brief Looks up the value stored under a string key (see insert(const std::string&, ...)).
+     */
+    const Value* get(const std::string& key, KeyHash hash = KeyHash::XXH64);
+
+    /**
+     * @brief Visits every key in [a, b] in ring order, clockwise from a.
+     *
+     * Routes once to the node responsible for a, then walks successor
+     * pointers, scanning each node's share of the range, until the node
+     * responsible for b. [a, a - 1] covers the whole ring.
+     * @param visit Called with each key and its value; returning false stops the scan.
+     */
+    RangeScanStats scan(NodeId a, NodeId b,
+                        const std::function<bool(const NodeId&, const Value&)>& visit);
+
+    /**
+     * @brief Copies out every key in [a, b] with its value, in ring order (see scan()).
+     * @param mode Walk scans node after node; FanOut first collects the
+     *        covering nodes, then scans them on `threads` threads.
+     * @param threads Worker threads for FanOut (0 = hardware concurrency).
+     * @param stats Receives the scan's cost when not null.
+     */
+    std::vector<std::pair<NodeId, Value>> rangeQuery(NodeId a, NodeId b, ScanMode mode = ScanMode::Walk,
+                                                     unsigned threads = 0, RangeScanStats* stats = nullptr);
+
+    /**
+     * @brief Writes a copy of every key this node owns to its next
+     *        REPLICATION_FACTOR - 1 live successors.
+     *
+     * stabilize() calls this when the successor list changes.
+     * @return The number of copies written.
+     */
+    int repairReplicas();
+
+    /**
+     * @brief Number of replicas (keys owned by other nodes) stored on this node.
+     */
+    size_t replicaCount() const { return replicaKeys_.size(); }
 
     /**
      * @brief Removes this node from the Chord network and migrates its keys.
+     *
+     * The whole store is spliced into the successor's, or with a non-zero
+     * `migrationChunk` the successor pulls it over in steps (see
+     * continueMigration()); the node must then stay allocated until
+     * migrating() turns false on the successor.
+     * @param migrationChunk Keys per migration step; 0 moves them all at once.
+     */
+    void leave(size_t migrationChunk = 0);
+
+    /**
+     * @brief Moves the next chunk of a streaming key migration into this node.
+     *
+     * stabilize() calls this once per run, so a large join or leave hands
+     * its keys over a chunk per round instead of stalling one round. The
+     * interval was taken out of the old holder's store when the migration
+     * began, so a step costs the chunk, not a pass over either store.
+     * Until a key arrives, get(), find(), removeKey(), scan() and
+     * rangeQuery() reach it in that staging buffer.
+     * Keys written here meanwhile win over the copies in transit.
+     * @return The number of keys moved; 0 once nothing is pending.
+     */
+    size_t continueMigration();
+
+    /**
+     * @brief Moves everything still pending in a streaming migration at once.
+     */
+    void finishMigration();
+
+    /**
+     * @brief Whether keys are still streaming into this node.
      */
-    void leave();
+    bool migrating() const { return incoming_.from != nullptr; }
+
+    /**
+     * @brief Simulates a crash: the node stops answering without telling anyone.
+     *
+     * Unlike leave(), neighbours are not patched and the node's keys are not
+     * handed over. Lookups route around the failed node through fingers and
+     * successor lists, and stabilize() repairs the links locally.
+     */
+    void fail();
 
     /**
      * @brief Removes a specific key from the Chord ring.
      * @param key The key to be removed.
      */
-    void removeKey(uint8_t key);
+    void removeKey(NodeId key);
 
     /**
      * @brief Finds the successor node responsible for a given key.
      * @param key The key to find.
-     * @return The successor node responsible for the key.
+     * @return The successor node responsible for the key, or nullptr if the
+     *         lookup reached a node whose whole successor list has failed.
      */
-    Node* find_successor(uint8_t key);
+    Node* find_successor(NodeId key);
+
+    /**
+     * @brief Iteratively routes a lookup for a key through the finger tables.
+     * @param key The key to find.
+     * @param recordPath Whether to record the visited nodes in the result.
+     * @param readReplica Stop as soon as the key falls within a visited
+     *        node's successor list and answer from one of its copies there
+     *        (owner or replica, chosen per origin to spread hot keys).
+     * Failed fingers and successors are skipped in favour of the closest
+     * live finger or the first live entry of the successor list.
+     * @return The responsible node (nullptr if the lookup could not get past
+     *         a node whose whole successor list failed), the hop count,
+     *         the failed entries skipped and optionally the path.
+     */
+    LookupResult lookup(NodeId key, bool recordPath = false, bool readReplica = false);
+
+    /**
+     * @brief Resolves many keys at once.
+     *
+     * Keys are sorted clockwise from this node and split into groups by the
+     * closest preceding finger they would take; each group is forwarded once
+     * per hop instead of once per key.
+     * @param keys The keys to find.
+     * @return One result per key, in the order of `keys` (paths are not recorded).
+     */
+    std::vector<LookupResult> lookupBatch(const std::vector<NodeId>& keys);
+
+    /**
+     * @brief Like lookup(), but answers from this node's location cache when it can.
+     *
+     * A cached owner is validated first (still in the ring, key still in
+     * (its predecessor, it]); a hit costs one hop, a stale entry is dropped
+     * and costs one extra hop before the regular lookup. Resolved owners are
+     * cached with their range. Without a cache this is lookup().
+     * insert(), get(), removeKey() and find() go through this, and the
+     * responsible node counts the request (getRequestsServed()).
+     */
+    LookupResult cachedLookup(NodeId key, bool recordPath = false, bool readReplica = false);
+
+    /**
+     * @brief Gives this node a location cache of `capacity` ranges (0 removes it).
+     */
+    void enableLocationCache(size_t capacity);
+
+    /**
+     * @brief This node's location cache, or nullptr if it has none.
+     */
+    const LocationCache* getLocationCache() const { return locationCache_.get(); }
 
     /**
      * @brief Prints the node's finger table.
@@ -119,8 +355,15 @@ public:
 
     /**
      * @brief Runs the stabilization protocol on this node.
+     *
+     * Moves the next chunk of a streaming key migration, drops a failed
+     * predecessor, replaces a failed successor with the first live entry
+     * of the successor list, and refreshes the list from the successor's
+     * own list.
+     * @return True if this node's successor, its successor list or its
+     *         successor's predecessor changed.
      */
-    void stabilize();
+    bool stabilize();
 
     /**
      * @brief Notifies this node about potential predecessor changes.
@@ -130,20 +373,64 @@ public:
 
     /**
      * @brief Periodically updates this node’s finger table.
+     * @return The number of finger entries that changed.
      */
-    void fix_fingers();
+    int fix_fingers();
 
     /**
      * @brief Finds the node responsible for a given key and prints the lookup path.
      * @param key The key to find.
      */
-    void find(uint8_t key);
+    void find(NodeId key);
 
     /**
      * @brief Gets the ID of this node.
      * @return The node's ID.
      */
-    uint8_t getId();
+    NodeId getId();
+
+    /**
+     * @brief Gets this node's handle in its pool.
+     */
+    NodeHandle getHandle() const { return handle_; }
+
+    /**
+     * @brief Gets the pool that owns this node.
+     */
+    NodePool* getPool() const { return pool_; }
+
+    /**
+     * @brief Gets the physical host this node (ring position) runs on.
+     *
+     * Nodes sharing a host are that host's virtual nodes; each keeps its own
+     * finger table, links and keys. A node is its own host (its handle) unless
+     * Ring::addNode or Ring::bootstrapHosts assigned one.
+     */
+    HostId getHost() const { return host_; }
+
+    /**
+     * @brief Number of keys stored on this node.
+     */
+    size_t keyCount() const { return localKeys_.size(); }
+
+    /**
+     * @brief Client requests (insert, get, removeKey, find) this node answered as the responsible node.
+     */
+    uint64_t getRequestsServed() const { return requestsServed_; }
+
+#if DHT_METRICS
+    /**
+     * @brief Protocol work done by this node (see NodeMetrics).
+     */
+    const NodeMetrics& getMetrics() const { return metrics_; }
+
+    void resetMetrics() { metrics_ = NodeMetrics(); }
+#endif
+
+    /**
+     * @brief Whether the node has joined and not left the ring.
+     */
+    bool isInRing() const { return inRing_; }
 
     /**
      * @brief Gets the successor of this node.
@@ -157,6 +444,12 @@ public:
      */
     Node* getPredecessor() { return predecessor_; }
 
+    /**
+     * @brief Gets entry i of the successor list (0 is the successor as of the last stabilize()).
+     * @param i Index in [0, SUCCESSOR_LIST_LENGTH).
+     */
+    Node* getSuccessorListEntry(int i) { return successorList_[i]; }
+
     /**
      * @brief Gets the i-th entry in the finger table.
      * @param i The index in the finger table.
@@ -165,7 +458,15 @@ public:
     Node* getFinger(int i) { return fingerTable_.get(i); }
 
     /**
-     * @brief Sets the successor node.
+     * @brief Gets this node's finger table.
+     */
+    const FingerTable& getFingerTable() const { return fingerTable_; }
+
+    /**
+     * @brief Sets the successor node (also the head of the successor list).
+     *
+     * A node already in the list drops the entries before it (they left);
+     * any other node is pushed in front (it joined).
      * @param node Pointer to the new successor.
      */
     void setSuccessor(Node* node);
@@ -177,19 +478,254 @@ public:
     void setPredecessor(Node* node);
 
 private:
-    uint8_t id_;                     ///< Unique node ID in [0 .. 2^BITLENGTH - 1]
+    friend class NodePool;   // Nodes are only constructed inside a pool
+    friend class Ring;       // Ring::bootstrap wires links, fingers and keys directly
+    friend class Simulator;  // Applies protocol messages to node state
+    friend class ActorRuntime;  // Applies mailbox messages on the node's own actor
+    friend class AsyncScheduler;  // Routes coroutine lookups hop by hop
+
+    /**
+     * @brief Constructs a node with a given ID (see NodePool::create).
+     * @param id Unique identifier of the node in the Chord ring.
+     * @param pool The pool that owns the node.
+     * @param handle The node's handle in that pool.
+     */
+    Node(NodeId id, NodePool* pool, NodeHandle handle);
+
+    NodeId id_;                      ///< Unique node ID in [0 .. 2^BITLENGTH - 1]
+    NodePool* pool_;                 ///< Pool that owns this node
+    NodeHandle handle_;              ///< This node's handle in pool_
+    HostId host_;                    ///< Physical host, see getHost()
+    uint64_t requestsServed_;        ///< See getRequestsServed()
+    bool inRing_;                    ///< Set by join(), cleared by leave()
     FingerTable fingerTable_;         ///< Finger table for efficient lookups
-    std::map<uint8_t, int> localKeys_; ///< Locally stored key-value pairs
+    KeyStore<Value> localKeys_;        ///< Locally stored key-value pairs
+    KeyStore<Value> replicaKeys_;      ///< Copies of keys owned by this node's predecessors
     Node* successor_;                ///< Pointer to this node’s successor
     Node* predecessor_;              ///< Pointer to this node’s predecessor
+    bool predecessorLost_;           ///< The predecessor failed; notify() promotes its replicas
+    Node* successorList_[SUCCESSOR_LIST_LENGTH];  ///< Nearest successors, refreshed by stabilize()
     size_t nextFingerToFix_;         ///< Used for periodic finger table maintenance
+    std::unique_ptr<LocationCache> locationCache_;  ///< Optional, see cachedLookup()
+#if DHT_METRICS
+    NodeMetrics metrics_;            ///< See getMetrics()
+#endif
+
+    /**
+     * @brief A streaming migration into this node: the keys of (start, end]
+     *        taken out of `from`'s store when it began, moved `chunk` at a time.
+     */
+    struct Migration {
+        Node* from = nullptr;        ///< nullptr when nothing is pending
+        NodeId start{};
+        NodeId end{};
+        size_t chunk = 0;
+        bool handOver = false;       ///< `from` is leaving (else this node joined in front of it)
+        std::vector<KeyStore<Value>::Entry> staged;   ///< The keys in ring order after start
+        std::vector<uint8_t> dropped;                 ///< Staged keys since rewritten or removed here
+        size_t next = 0;             ///< First staged key not moved yet
+    };
+    Migration incoming_;             ///< See continueMigration()
+    Node* outgoing_;                 ///< Node pulling keys out of this one, nullptr if none
 
     /**
      * @brief Finds the closest preceding finger for a given key.
      * @param key The key being searched for.
      * @return Pointer to the closest preceding finger.
      */
-    Node* closest_preceding_finger(uint8_t key);
+    Node* closest_preceding_finger(NodeId key);
+
+    /**
+     * @brief Like closest_preceding_finger(), but only returns nodes still in the ring.
+     *
+     * A failed choice falls back to lower fingers and the successor list.
+     * @param key The key being searched for.
+     * @param timeouts Incremented for every failed entry that was skipped.
+     * @return The closest live preceding node, or this node if there is none.
+     */
+    Node* closest_preceding_live(NodeId key, int& timeouts);
+
+    /**
+     * @brief Whether this node is in the ring and `key` lies in (predecessor, this].
+     */
+    bool ownsKey(NodeId key);
+
+    /**
+     * @brief Moves the keys of (a, b] from this node's store to `to`'s in one splice.
+     *
+     * On a join (`handOver` false) this node keeps a replica of each key,
+     * as `to`'s new successor; on a leave `to` drops its replicas of them
+     * and its last replica target gets one, so the count stays the same.
+     * @return The number of keys moved.
+     */
+    size_t moveKeys(Node* to, const NodeId& a, const NodeId& b, bool handOver);
+
+    /**
+     * @brief Replica upkeep and logging for one key this node hands to `to` (see moveKeys()).
+     * @param shiftedHolder The replica holder a join pushes out (this node's
+     *        last replica target) or a leave brings in (`to`'s), or nullptr.
+     */
+    void handOffKey(Node* to, const NodeId& key, const Value& value, bool handOver, Node* shiftedHolder);
+
+    /**
+     * @brief The last of this node's replica targets; nullptr if the list is short.
+     */
+    Node* lastReplicaTarget();
+
+    /**
+     * @brief Ends the streaming migration into this node, dropping whatever is still staged.
+     */
+    void endMigration();
+
+    /**
+     * @brief Puts the staged keys not moved yet back into the source's store.
+     */
+    void returnStaged();
+
+    /**
+     * @brief Ends a streaming migration whose source failed, restoring the
+     *        keys it had not sent yet from the source's replica holders.
+     *
+     * Like promoteReplicas(), but over the interval this node was still
+     * pulling, and reading the copies on its successors, where the source
+     * kept them.
+     * @return The number of keys restored.
+     */
+    size_t recoverStaged();
+
+    /**
+     * @brief Visits the staged keys not moved yet (and not rewritten here) in ring order.
+     */
+    void forEachStaged(const std::function<void(const NodeId&, const Value&)>& visit) const;
+
+    /**
+     * @brief Visits the keys this node holds in (a, b] in ring order, with
+     *        those still staged for it merged in (see scan()).
+     * @return False if visit stopped the walk.
+     */
+    bool forEachStoredInInterval(const NodeId& a, const NodeId& b,
+                                 const std::function<bool(const NodeId&, const Value&)>& visit) const;
+
+    /**
+     * @brief Visits every key whose replicas this node keeps up: its own and
+     *        the staged keys of a migration it answers for.
+     */
+    void forEachReplicated(const std::function<void(const NodeId&, const Value&)>& visit) const;
+
+    /**
+     * @brief Starts moving (a, b] from `from` into this node, all at once or `chunk` keys per step.
+     */
+    void beginMigration(Node* from, const NodeId& a, const NodeId& b, size_t chunk, bool handOver);
+
+    /**
+     * @brief Index of `key` among the staged keys not moved yet, or -1.
+     */
+    ptrdiff_t stagedIndex(const NodeId& key) const;
+
+    /**
+     * @brief A key in the pending interval of a streaming migration into
+     *        this node, still staged; nullptr otherwise.
+     */
+    Value* findInTransit(const NodeId& key);
+
+    /**
+     * @brief Discards the staged copy of a key this node is writing or
+     *        removing, and the source's replicas of it, so no old holder can
+     *        answer with the previous value.
+     */
+    void dropInTransit(const NodeId& key);
+
+    /**
+     * @brief The value a lookup for `key` reached: the holder's own, replica
+     *        or in-transit copy.
+     */
+    static const Value* storedValue(const LookupResult& result, const NodeId& key);
+
+    /**
+     * @brief Copies one key to the next REPLICATION_FACTOR - 1 live successors.
+     * @return The number of copies written.
+     */
+    int replicate(const NodeId& key, const Value& value);
+
+    /**
+     * @brief Erases the copies replicate() wrote for `key`.
+     */
+    void dropReplicas(const NodeId& key);
+
+    /**
+     * @brief The live successors holding this node's replicas, at most REPLICATION_FACTOR - 1.
+     * @return The number of entries written to `out`.
+     */
+    int replicaTargets(Node** out);
+
+    /**
+     * @brief Erases this node's keys from the nodes in `before` that are no longer replica targets.
+     *
+     * Called when the successor list changes, so a later removeKey() or
+     * replica promotion cannot meet a copy left behind.
+     */
+    void dropStaleReplicas(Node* const* before, int count);
+
+    /**
+     * @brief Turns replicas of keys in (predecessor, this] into owned keys.
+     *
+     * Called when a failed predecessor is replaced: its keys survive as
+     * this node's replicas.
+     * @return The number of keys promoted.
+     */
+    size_t promoteReplicas();
+
+    /**
+     * @brief For lookup(readReplica): a live copy holder of `key` within the successor list.
+     * @param replica Set when the holder only has a replica.
+     * @return nullptr if the key lies past the successor list or no holder has a copy.
+     */
+    Node* replicaHolder(NodeId key, NodeHandle origin, bool& replica);
+
+    /**
+     * @brief The successor if it is in the ring, else the first live successor list entry.
+     * @return nullptr if every known successor has failed.
+     */
+    Node* liveSuccessor();
+
+    /**
+     * @brief Walks the nodes covering [a, b], handing each its share (start, end] in ring order.
+     * @param segment Called with a node and its share; returning false stops the walk.
+     */
+    RangeScanStats walkRange(NodeId a, NodeId b,
+                             const std::function<bool(Node*, const NodeId&, const NodeId&)>& segment);
+
+#if DHT_METRICS
+    /**
+     * @brief Counts `keys` keys moved to this node from `from` (nullptr: promoted replicas).
+     */
+    void recordMigration(Node* from, size_t keys);
+
+    /**
+     * @brief Counts a finished lookup started at this node.
+     */
+    void recordLookup(const LookupResult& result) {
+        metrics_.lookups++;
+        metrics_.lookupHops += (uint64_t)result.hops;
+        metrics_.lookupTimeouts += (uint64_t)result.timeouts;
+        metrics_.hopsPerLookup.record((uint64_t)result.hops);
+    }
+#endif
+
+    /**
+     * @brief Rebuilds the successor list as successor_ followed by the successor's list.
+     * @return True if any entry changed.
+     */
+    bool refreshSuccessorList();
+
+    /**
+     * @brief Points every finger whose start lies in (arcStart, arcEnd] at `owner`.
+     * @param arcStart Exclusive start of the arc whose owner changed.
+     * @param arcEnd Inclusive end of the arc whose owner changed.
+     * @param owner The node now responsible for the arc.
+     * @return The number of finger entries that changed.
+     */
+    int repairFingerArc(NodeId arcStart, NodeId arcEnd, Node* owner);
 
     /**
      * @brief Checks if a value is in a given ring interval.
@@ -200,7 +736,7 @@ private:
      * @param inclusiveEnd Whether to include the end in the interval.
      * @return True if x is in the interval, false otherwise.
      */
-    bool inInterval(uint8_t x, uint8_t start, uint8_t end,
+    bool inInterval(NodeId x, NodeId start, NodeId end,
                     bool inclusiveStart = false, bool inclusiveEnd = false);
 };
 
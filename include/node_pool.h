@@ -0,0 +1,62 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "node.h"
+
+/**
+ * @class NodePool
+ * @brief Contiguous storage for nodes, addressed by 32-bit handles.
+ *
+ * Nodes live in fixed-size chunks of kChunkSize consecutive objects, so a
+ * handle resolves with a shift and a mask, neighbouring handles share cache
+ * lines, and node addresses never change once created. Nodes are only
+ * destroyed together, by clear() or the pool's destructor.
+ */
+class NodePool {
+public:
+    static const int kChunkBits = 10;
+    static const size_t kChunkSize = (size_t)1 << kChunkBits;
+
+    NodePool();
+    ~NodePool();
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    /**
+     * @brief Constructs a new node in the pool.
+     * @param id Identifier of the new node.
+     * @return Handle of the new node (handles are assigned 0, 1, 2, ...).
+     */
+    NodeHandle create(NodeId id);
+
+    /**
+     * @brief Resolves a handle to its node.
+     */
+    Node* get(NodeHandle handle) const {
+        return chunks_[handle >> kChunkBits] + (handle & (kChunkSize - 1));
+    }
+
+    /**
+     * @brief Number of nodes created so far.
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Pre-allocates chunks for at least n nodes.
+     */
+    void reserve(size_t n);
+
+    /**
+     * @brief Destroys every node and releases all chunks.
+     */
+    void clear();
+
+private:
+    std::vector<Node*> chunks_;   ///< Raw storage, kChunkSize nodes per chunk
+    size_t size_;                 ///< Nodes constructed so far
+};
+
+#endif  // NODE_POOL_H
@@ -0,0 +1,31 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs fn(begin, end) on contiguous slices of [0, n), one per thread.
+ * @param threads Number of slices; 0 uses all cores. With one slice fn runs on the caller.
+ */
+template <typename Fn>
+void parallelFor(size_t n, unsigned threads, Fn fn) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, n);
+    if (threads <= 1) {
+        fn((size_t)0, n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    size_t chunk = (n + threads - 1) / threads;
+    for (size_t begin = 0; begin < n; begin += chunk) {
+        workers.emplace_back(fn, begin, std::min(n, begin + chunk));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+#endif  // PARALLEL_H
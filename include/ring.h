@@ -0,0 +1,245 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "identifier.h"
+#include "location_cache.h"
+#include "metrics.h"
+#include "node_pool.h"
+#include "ring_snapshot.h"
+#include "value.h"
+
+/**
+ * @brief How ring-wide maintenance rounds are applied.
+ */
+enum class RoundMode {
+    Serial,     ///< Nodes update one after another and see earlier updates of the same round
+    Parallel    ///< Nodes compute their updates from the previous round in parallel, then commit together
+};
+
+/**
+ * @brief What Ring::rebalance evens out across hosts.
+ */
+enum class LoadMetric {
+    Keys,       ///< Keys stored
+    Requests    ///< Client requests served (Node::getRequestsServed)
+};
+
+/**
+ * @struct HostLoad
+ * @brief Load of one physical host, summed over its virtual nodes in the ring.
+ */
+struct HostLoad {
+    HostId host = kNoHost;
+    size_t virtualNodes = 0;   ///< Ring positions the host runs
+    size_t keys = 0;           ///< Keys stored
+    uint64_t requests = 0;     ///< Client requests served
+};
+
+/**
+ * @class Ring
+ * @brief Owns the nodes of one Chord ring.
+ *
+ * Nodes live in a NodePool and are addressed by handle. They can be added
+ * one by one and joined through the protocol, or a whole converged ring can
+ * be built at once with bootstrap(). Ring-wide operations scan the pool
+ * instead of walking successor pointers.
+ */
+class Ring {
+public:
+    Ring();
+    ~Ring();
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    /**
+     * @brief Creates a node owned by this ring. The node still has to join().
+     * @param id Identifier of the new node.
+     * @param host Physical host running the node; kNoHost gives it a host of its own.
+     * @return Pointer to the new node (stable for the lifetime of the ring).
+     */
+    Node* addNode(NodeId id, HostId host = kNoHost);
+
+    /**
+     * @brief Builds a converged ring from a set of IDs in one pass.
+     *
+     * IDs are sorted and de-duplicated once, successor/predecessor links are
+     * wired directly, every finger table is filled by binary search over the
+     * sorted IDs (split across threads), and the initial keys are handed to
+     * their owners in a single merge pass.
+     * @param ids Node identifiers (any order, duplicates ignored).
+     * @param keys Initial key-value pairs, moved into the ring.
+     * @param threads Worker threads for the finger fill; 0 uses all cores.
+     * @return False (and does nothing) if the ring already has nodes.
+     */
+    bool bootstrap(std::vector<NodeId> ids,
+                   std::vector<std::pair<NodeId, Value>> keys = std::vector<std::pair<NodeId, Value>>(),
+                   unsigned threads = 0);
+
+    /**
+     * @brief Like bootstrap(), with several virtual IDs per physical host.
+     * @param positions (ID, host) pairs; every ID becomes a node on that host.
+     * @param keys Initial key-value pairs, moved into the ring.
+     * @param threads Worker threads for the finger fill; 0 uses all cores.
+     * @return False (and does nothing) if the ring already has nodes.
+     */
+    bool bootstrapHosts(std::vector<std::pair<NodeId, HostId>> positions,
+                        std::vector<std::pair<NodeId, Value>> keys = std::vector<std::pair<NodeId, Value>>(),
+                        unsigned threads = 0);
+
+    /**
+     * @brief Writes the whole ring to `path` in the RingSnapshot format.
+     *
+     * Saves every node (including nodes that left) in handle order with its
+     * ID, host, links, successor list, finger table, owned keys and replicas.
+     * Streaming key migrations are not recorded: keys still staged for
+     * their new holder are left out, so call Node::finishMigration() first.
+     * @return False if the file could not be written.
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Rebuilds a saved ring from an open snapshot without running any protocol step.
+     *
+     * Handles, links, fingers and keys come back exactly as saved; location
+     * caches and metrics start empty.
+     * @param threads Worker threads filling the nodes; 0 uses all cores.
+     * @return False (and does nothing) if the ring already has nodes or the snapshot is not open.
+     */
+    bool load(const RingSnapshot& snapshot, unsigned threads = 0);
+
+    /**
+     * @brief Runs stabilization on every node in the ring until it converges.
+     *
+     * In Parallel mode every round reads only the previous round's links:
+     * each node picks its new successor, the closest notifier becomes each
+     * node's predecessor, and all links are committed at once. The outcome
+     * does not depend on node order or thread count.
+     * @param mode Serial (Node::stabilizeAll) or Parallel rounds.
+     * @param threads Worker threads for Parallel mode; 0 uses all cores.
+     * @return The number of rounds that were run.
+     */
+    int stabilizeNetwork(RoundMode mode = RoundMode::Serial, unsigned threads = 0);
+
+    /**
+     * @brief Fixes the finger tables of every node in the ring until they converge.
+     *
+     * In Parallel mode every round resolves all fingers against the previous
+     * round's tables into a second buffer, then commits them at once.
+     * @param mode Serial (Node::fixAllFingers) or Parallel rounds.
+     * @param threads Worker threads for Parallel mode; 0 uses all cores.
+     * @return The number of finger entries that changed.
+     */
+    int fixAllFingers(RoundMode mode = RoundMode::Serial, unsigned threads = 0);
+
+    /**
+     * @brief Gives every node a location cache of `capacity` ranges (0 removes them).
+     * @see Node::cachedLookup
+     */
+    void enableLocationCaches(size_t capacity);
+
+    /**
+     * @brief Location cache counters summed over all nodes.
+     */
+    LocationCacheStats locationCacheStats() const;
+
+    /**
+     * @brief Copies every node's protocol counters and the ring-wide ones (Metrics::global()).
+     *
+     * Nodes that left are included, so their work is not lost from the totals.
+     * With -DDHT_METRICS=0 the snapshot is empty and marked disabled.
+     */
+    MetricsSnapshot metrics() const;
+
+    /**
+     * @brief Zeroes every node's counters and the ring-wide ones.
+     */
+    void resetMetrics();
+
+    /**
+     * @brief Load of every host with a node in the ring, in host order.
+     */
+    std::vector<HostLoad> hostLoads() const;
+
+    /**
+     * @brief Nodes in the ring running on `host`.
+     */
+    std::vector<Node*> hostNodes(HostId host) const;
+
+    /**
+     * @brief Moves virtual nodes off overloaded hosts.
+     *
+     * While the busiest host carries more than `maxRatio` times the mean
+     * load, its virtual node that best evens out the busiest and the idlest
+     * host is reassigned to the idlest one. Ring positions do not change, so
+     * routing is unaffected; the node's keys and finger table simply move to
+     * another machine. Every host keeps at least one virtual node, and a move
+     * is only made if it lowers the busier host's load.
+     * @param metric The load to even out.
+     * @param maxRatio Target bound on max / mean host load.
+     * @param maxMoves Upper bound on reassigned virtual nodes.
+     * @return The number of virtual nodes moved.
+     */
+    int rebalance(LoadMetric metric, double maxRatio = 1.25, int maxMoves = 1 << 20);
+
+    /**
+     * @brief Zeroes every node's served-request counter.
+     */
+    void resetRequestCounts();
+
+    /**
+     * @brief Prints the keys of every node in the ring, in ID order.
+     */
+    void printAllKeys() const;
+
+    /**
+     * @brief Prints the finger table of every node in the ring, in ID order.
+     */
+    void printAllFingerTables() const;
+
+    /**
+     * @brief Destroys every node.
+     */
+    void clear() { pool_.clear(); }
+
+    /**
+     * @brief Number of nodes owned by this ring (including nodes that left).
+     */
+    size_t size() const { return pool_.size(); }
+
+    /**
+     * @brief The node with handle h (handles follow creation order; ring order after bootstrap()).
+     */
+    Node* node(NodeHandle h) const { return pool_.get(h); }
+
+    /**
+     * @brief All nodes owned by this ring, in handle order.
+     */
+    std::vector<Node*> nodes() const;
+
+    /**
+     * @brief Nodes currently in the ring (joined and not left), in handle order.
+     */
+    std::vector<Node*> activeNodes() const;
+
+    /**
+     * @brief The pool holding this ring's nodes.
+     */
+    const NodePool& pool() const { return pool_; }
+
+private:
+    /**
+     * @brief Active nodes sorted by ID, for printing.
+     */
+    std::vector<Node*> activeNodesById() const;
+
+    int stabilizeParallel(unsigned threads);
+    int fixFingersParallel(unsigned threads);
+
+    NodePool pool_;   ///< Contiguous node storage
+};
+
+#endif  // RING_H
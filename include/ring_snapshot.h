@@ -0,0 +1,159 @@
+#ifndef RING_SNAPSHOT_H
+#define RING_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "finger_table.h"
+#include "identifier.h"
+#include "node.h"
+
+/**
+ * @brief Format version written by Ring::save(); RingSnapshot::open() rejects any other.
+ */
+static const uint32_t kRingSnapshotVersion = 1;
+
+/**
+ * @class RingSnapshot
+ * @brief Read-only, memory-mapped view of a ring saved with Ring::save().
+ *
+ * The file holds no pointers: nodes refer to each other by pool handle, and
+ * every section is an array at a fixed offset, so the mapped file is usable
+ * in place as soon as open() has checked it. Layout (native byte order,
+ * sections 64-byte aligned):
+ * @code
+ * Header          magic "DHTRING", version, byte order mark, BITLENGTH,
+ *                 sizeof(NodeId), SUCCESSOR_LIST_LENGTH, counts, section offsets
+ * ids             NodeId[nodes]                      in handle order
+ * nodes           NodeRecord[nodes]                  host, links, flags, key range
+ * fingers         NodeHandle[nodes][BITLENGTH]       finger 1..BITLENGTH of each node
+ * successorLists  NodeHandle[nodes][SUCCESSOR_LIST_LENGTH]
+ * keys            NodeId[keys]                       per node: owned keys, then replicas, each sorted
+ * values          ValueRecord[keys]                  offset and size in `data`, or "None"
+ * data            value bytes
+ * @endcode
+ * A snapshot only opens in a build with the same BITLENGTH and
+ * SUCCESSOR_LIST_LENGTH on a machine with the same byte order.
+ */
+class RingSnapshot {
+public:
+    RingSnapshot();
+    ~RingSnapshot();
+    RingSnapshot(const RingSnapshot&) = delete;
+    RingSnapshot& operator=(const RingSnapshot&) = delete;
+
+    /**
+     * @brief Maps a snapshot file and checks its header and every handle, key range and value range.
+     * @return False (see error()) if the file cannot be mapped or is not a valid snapshot for this build.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+
+    /**
+     * @brief Why the last open() failed, empty if it did not.
+     */
+    const std::string& error() const { return error_; }
+
+    size_t nodeCount() const { return base_ ? (size_t)header()->nodeCount : 0; }
+
+    /**
+     * @brief Owned and replica keys of all nodes.
+     */
+    size_t keyCount() const { return base_ ? (size_t)header()->keyCount : 0; }
+
+    // Per-node accessors; h must be below nodeCount()
+
+    const NodeId& nodeId(NodeHandle h) const { return ids_[h]; }
+    HostId host(NodeHandle h) const { return nodes_[h].host; }
+    bool inRing(NodeHandle h) const { return (nodes_[h].flags & kInRing) != 0; }
+    NodeHandle successor(NodeHandle h) const { return nodes_[h].successor; }
+
+    /**
+     * @brief The predecessor's handle, kNullHandle if the node had none.
+     */
+    NodeHandle predecessor(NodeHandle h) const { return nodes_[h].predecessor; }
+
+    /**
+     * @brief Finger i (1..BITLENGTH) of node h, kNullHandle if unset.
+     */
+    NodeHandle finger(NodeHandle h, int i) const { return fingers_[(size_t)h * BITLENGTH + i - 1]; }
+
+    NodeHandle successorListEntry(NodeHandle h, int k) const {
+        return successorLists_[(size_t)h * SUCCESSOR_LIST_LENGTH + k];
+    }
+
+    /**
+     * @brief Number of keys node h owned (replicas excluded).
+     */
+    size_t ownedKeyCount(NodeHandle h) const { return nodes_[h].ownedKeys; }
+
+private:
+    friend class Ring;   // Ring::save() writes these records, Ring::load() reads them
+
+    static const uint32_t kInRing = 1;      ///< NodeRecord::flags
+    static const uint32_t kHasValue = 1;    ///< ValueRecord::flags; without it the value is "None"
+
+    struct Header {
+        char magic[8];               ///< "DHTRING" and a NUL
+        uint32_t version;            ///< kRingSnapshotVersion
+        uint32_t byteOrder;          ///< 0x01020304 as written by the saving machine
+        uint32_t bitLength;
+        uint32_t idSize;             ///< sizeof(NodeId)
+        uint32_t successorListLength;
+        uint32_t replicationFactor;  ///< Informational: replicas are rebuilt by stabilization anyway
+        uint64_t nodeCount;
+        uint64_t keyCount;
+        uint64_t dataBytes;
+        uint64_t idsOffset;
+        uint64_t nodesOffset;
+        uint64_t fingersOffset;
+        uint64_t successorListsOffset;
+        uint64_t keysOffset;
+        uint64_t valuesOffset;
+        uint64_t dataOffset;
+        uint64_t fileSize;
+    };
+
+    struct NodeRecord {
+        HostId host;
+        NodeHandle successor;
+        NodeHandle predecessor;      ///< kNullHandle if none
+        uint32_t flags;
+        uint64_t requestsServed;
+        uint64_t firstKey;           ///< Index of the node's first key in `keys`
+        uint32_t ownedKeys;          ///< Owned keys, then `replicaKeys` replicas
+        uint32_t replicaKeys;
+    };
+
+    struct ValueRecord {
+        uint64_t offset;             ///< In `data`
+        uint32_t size;
+        uint32_t flags;
+    };
+
+    const Header* header() const { return reinterpret_cast<const Header*>(base_); }
+
+    /**
+     * @brief Records the reason, unmaps the file and returns false.
+     */
+    bool fail(const std::string& message);
+
+    const uint8_t* base_;
+    size_t size_;
+    const NodeId* ids_;
+    const NodeRecord* nodes_;
+    const NodeHandle* fingers_;
+    const NodeHandle* successorLists_;
+    const NodeId* keys_;
+    const ValueRecord* values_;
+    const uint8_t* data_;
+    std::string error_;
+};
+
+#endif  // RING_SNAPSHOT_H
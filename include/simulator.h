@@ -0,0 +1,177 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+#include "identifier.h"
+#include "finger_table.h"
+
+class Node;
+class Ring;
+
+typedef uint64_t SimTime;   ///< Virtual time in microseconds
+
+/**
+ * @struct LinkModel
+ * @brief Latency and loss of every node-to-node message.
+ *
+ * One-way latency of a link is base + a fixed per-link offset in
+ * [0, spread] (derived from the two handles, so it is stable over the run)
+ * + a per-message jitter in [0, jitter]. Messages a node sends to itself
+ * are delivered immediately and never lost.
+ */
+struct LinkModel {
+    SimTime baseUs = 10000;      ///< Minimum one-way latency
+    SimTime spreadUs = 90000;    ///< Range of the per-link offset
+    SimTime jitterUs = 5000;     ///< Range of the per-message jitter
+    double lossRate = 0.0;       ///< Probability that a message is dropped
+};
+
+/**
+ * @struct SimConfig
+ * @brief Parameters of a simulation run.
+ */
+struct SimConfig {
+    LinkModel link;
+    SimTime stabilizeIntervalUs = 1000000;    ///< Period of stabilize() per node
+    SimTime fixFingerIntervalUs = 250000;     ///< Period of fixing one finger per node
+    SimTime lookupTimeoutUs = 5000000;        ///< Lookups not answered by then fail
+    uint64_t seed = 1;                        ///< Seed for jitter, loss and timer phases
+};
+
+/**
+ * @struct SimReport
+ * @brief Outcome of a simulation run.
+ */
+struct SimReport {
+    uint64_t events = 0;              ///< Events processed
+    uint64_t messagesSent = 0;        ///< Node-to-node messages sent
+    uint64_t messagesLost = 0;        ///< Messages dropped by the link model
+    uint64_t lookupsIssued = 0;       ///< Client lookups scheduled
+    uint64_t lookupsCompleted = 0;    ///< Client lookups answered before their timeout
+    uint64_t lookupsFailed = 0;       ///< Client lookups that timed out
+    double meanHops = 0;              ///< Mean forwarding hops of completed lookups
+    double meanLatencyUs = 0;         ///< Mean latency of completed lookups
+    SimTime p50Us = 0, p90Us = 0, p99Us = 0, p999Us = 0, maxUs = 0;
+    SimTime endTimeUs = 0;            ///< Virtual time when the run stopped
+
+    void print(std::ostream& out) const;
+};
+
+/**
+ * @class Simulator
+ * @brief Discrete-event execution of the Chord protocol over a Ring.
+ *
+ * Every interaction between nodes is a timestamped message on a priority
+ * queue: find_successor hops and replies, stabilize's predecessor query,
+ * notify, and the lookups fix_fingers issues. A virtual clock advances from
+ * event to event, so lookup latency reflects the configured link model.
+ * Events are 40 bytes and reference nodes by pool handle, and lookup slots
+ * are recycled once they time out, so runs with 10^5 nodes and 10^7 events
+ * stay within a few hundred MB.
+ */
+class Simulator {
+public:
+    Simulator(Ring& ring, const SimConfig& config = SimConfig());
+
+    /**
+     * @brief Schedules a client lookup issued by `origin` at virtual time `at`.
+     */
+    void scheduleLookup(SimTime at, Node* origin, NodeId key);
+
+    /**
+     * @brief Starts periodic stabilize and fix_fingers on every node in the ring.
+     * @param untilUs No maintenance timer fires after this time.
+     */
+    void startMaintenance(SimTime untilUs);
+
+    /**
+     * @brief Processes events in time order until the queue is empty or `untilUs` is passed.
+     */
+    void run(SimTime untilUs = ~(SimTime)0);
+
+    SimTime now() const { return now_; }
+
+    /**
+     * @brief Counters and latency percentiles of the run so far.
+     */
+    SimReport report() const;
+
+private:
+    enum MsgType : uint8_t {
+        FindSuccessor,      // Route a lookup one hop further
+        LookupReply,        // Responsible node answers the origin
+        LookupTimeout,      // Origin gives up on a lookup
+        GetPredecessor,     // stabilize(): ask the successor for its predecessor
+        PredecessorReply,   // ... and its answer
+        Notify,             // stabilize(): tell the successor about ourselves
+        StabilizeTimer,     // Periodic stabilize() on a node
+        FixFingerTimer      // Periodic fix of the next finger on a node
+    };
+
+    struct Event {
+        SimTime time;
+        uint64_t seq;           // Tie-break: FIFO among simultaneous events
+        uint32_t lookup;        // Lookup slot
+        uint32_t generation;    // Generation of the slot, so stale messages are ignored
+        NodeHandle src;
+        NodeHandle dst;
+        NodeHandle arg;         // Result or predecessor handle
+        MsgType type;
+    };
+
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+        }
+    };
+
+    struct Lookup {
+        SimTime start;
+        NodeId key;
+        NodeHandle origin;
+        uint32_t generation;    // Bumped each time the slot is reused
+        uint16_t hops;
+        uint8_t finger;         // Finger index being fixed, 0 for client lookups
+        uint8_t done;
+    };
+
+    void push(SimTime time, MsgType type, NodeHandle src, NodeHandle dst, uint32_t lookup, NodeHandle arg);
+    void send(MsgType type, NodeHandle src, NodeHandle dst, uint32_t lookup, NodeHandle arg);
+    SimTime linkLatency(NodeHandle src, NodeHandle dst);
+    uint32_t startLookup(SimTime at, NodeHandle origin, NodeId key, uint8_t finger);
+    bool isCurrent(const Event& e) const;
+    void dispatch(const Event& e);
+
+    void onFindSuccessor(const Event& e);
+    void onLookupReply(const Event& e);
+    void onLookupTimeout(const Event& e);
+    void onStabilizeTimer(const Event& e);
+    void onGetPredecessor(const Event& e);
+    void onPredecessorReply(const Event& e);
+    void onNotify(const Event& e);
+    void onFixFingerTimer(const Event& e);
+
+    Ring& ring_;
+    SimConfig config_;
+    std::priority_queue<Event, std::vector<Event>, Later> queue_;
+    std::vector<Lookup> lookups_;
+    std::vector<uint32_t> freeLookups_;   ///< Recycled lookup slots
+    std::vector<SimTime> latencies_;   ///< Latencies of completed client lookups
+    std::mt19937_64 rng_;
+    SimTime now_;
+    SimTime maintenanceUntil_;
+    uint64_t seq_;
+
+    uint64_t events_;
+    uint64_t messagesSent_;
+    uint64_t messagesLost_;
+    uint64_t lookupsIssued_;
+    uint64_t lookupsFailed_;
+    uint64_t completedHops_;
+};
+
+#endif  // SIMULATOR_H
@@ -0,0 +1,201 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "identifier.h"
+#include "value.h"
+
+class Node;
+class Ring;
+
+/**
+ * @brief Operation kinds of a workload trace.
+ */
+enum class TraceOpType : uint8_t {
+    Join = 1,        ///< A node with ID `id` joins (through `origin`, if given)
+    Leave = 2,       ///< Node `id` leaves gracefully
+    Insert = 3,      ///< Store `value` under key `id`
+    Remove = 4,      ///< Remove key `id`
+    Lookup = 5,      ///< Resolve the node responsible for key `id`
+    Stabilize = 6,   ///< Ring::stabilizeNetwork()
+    FixFingers = 7   ///< Ring::fixAllFingers()
+};
+
+/**
+ * @struct TraceOp
+ * @brief One trace record.
+ */
+struct TraceOp {
+    TraceOpType type = TraceOpType::Lookup;
+    NodeId id = NodeId();        ///< Node ID (Join, Leave) or key (Insert, Remove, Lookup)
+    bool hasOrigin = false;      ///< Whether `origin` names the node issuing the operation
+    NodeId origin = NodeId();    ///< Issuing node (Join: the known node)
+    Value value;                 ///< Value of an Insert (std::nullopt = "None")
+};
+
+/**
+ * @brief Encoding of a trace file.
+ *
+ * Text: one operation per line, `#` starts a comment, IDs in decimal:
+ * @code
+ * join <id> [@<known>]
+ * leave <id>
+ * insert <key> [<value>] [@<origin>]
+ * remove <key> [@<origin>]
+ * lookup <key> [@<origin>]
+ * stabilize
+ * fix_fingers
+ * @endcode
+ * Values are text with %XX escapes for spaces, control bytes, '%', '#'
+ * and '@'; `-` (or no value) stores "None". Without `@origin` the live
+ * node with the lowest ID issues the operation.
+ *
+ * Binary: the 8-byte magic "DHTTRACE", a version byte (1), a reserved byte
+ * and the ID width in bits (16-bit little-endian), then per record a byte
+ * holding the type (low nibble), 0x10 if an origin follows and 0x20 if a
+ * value follows; the ID and the origin as big-endian (bits + 7) / 8 byte
+ * integers; the value as a LEB128 length and its bytes.
+ */
+enum class TraceFormat {
+    Text,
+    Binary
+};
+
+/**
+ * @class TraceReader
+ * @brief Streams trace records from a text or binary trace, detected from the first bytes.
+ *
+ * Reads through a fixed buffer, so traces of any length take constant memory.
+ */
+class TraceReader {
+public:
+    explicit TraceReader(std::istream& in);
+
+    /**
+     * @brief Reads the next record.
+     * @return False at the end of the trace or on a malformed record (see error()).
+     */
+    bool next(TraceOp& op);
+
+    TraceFormat format() const { return format_; }
+
+    /**
+     * @brief Description of the first malformed record, empty if none was met.
+     */
+    const std::string& error() const { return error_; }
+
+    /**
+     * @brief Records read so far.
+     */
+    uint64_t records() const { return records_; }
+
+private:
+    bool fill();
+    bool readByte(uint8_t& byte);
+    bool readBytes(void* out, size_t size);
+    bool readLine(std::string& line);
+    bool nextText(TraceOp& op);
+    bool nextBinary(TraceOp& op);
+    bool fail(const std::string& message);
+
+    std::istream& in_;
+    std::vector<char> buffer_;
+    size_t pos_;
+    size_t end_;
+    TraceFormat format_;
+    int idBytes_;            ///< Bytes per ID in a binary trace
+    uint64_t records_;
+    uint64_t line_;          ///< Current line of a text trace
+    std::string error_;
+};
+
+/**
+ * @class TraceWriter
+ * @brief Writes trace records in either format.
+ */
+class TraceWriter {
+public:
+    TraceWriter(std::ostream& out, TraceFormat format);
+
+    void write(const TraceOp& op);
+
+    /**
+     * @brief Records written so far.
+     */
+    uint64_t records() const { return records_; }
+
+private:
+    std::ostream& out_;
+    TraceFormat format_;
+    uint64_t records_;
+};
+
+/**
+ * @struct TraceStats
+ * @brief What a TraceRunner did so far.
+ */
+struct TraceStats {
+    uint64_t applied = 0;        ///< Records applied
+    uint64_t skipped = 0;        ///< Records naming a node that is not in the ring, or a duplicate join
+    uint64_t joins = 0;
+    uint64_t leaves = 0;
+    uint64_t inserts = 0;
+    uint64_t removes = 0;
+    uint64_t lookups = 0;
+    uint64_t unresolved = 0;     ///< Lookups that found no live responsible node
+    uint64_t lookupHops = 0;     ///< Hops of all lookups
+    uint64_t stabilizeRounds = 0;
+    uint64_t fingersChanged = 0;
+};
+
+/**
+ * @class TraceRunner
+ * @brief Applies trace records to a Ring through the Node API, optionally recording them.
+ *
+ * The runner keeps an index of the nodes in the ring by ID. Applied
+ * records are passed to the recorder with the origin that actually issued
+ * them, so a recording replays exactly; skipped records are not recorded.
+ * Code that drives a ring through apply() is recorded the same way.
+ */
+class TraceRunner {
+public:
+    /**
+     * @param ring The ring to drive; nodes already in it are picked up.
+     * @param recorder Receives every applied record, or nullptr.
+     */
+    explicit TraceRunner(Ring& ring, TraceWriter* recorder = nullptr);
+
+    /**
+     * @brief Applies one record (its value is moved into the ring).
+     * @return False if the record was skipped.
+     */
+    bool apply(TraceOp& op);
+
+    /**
+     * @brief Applies every record of `reader`.
+     * @return False if the trace ended with a malformed record.
+     */
+    bool run(TraceReader& reader);
+
+    const TraceStats& stats() const { return stats_; }
+
+    /**
+     * @brief The node in the ring with this ID, or nullptr.
+     */
+    Node* node(const NodeId& id) const;
+
+private:
+    Node* origin(const TraceOp& op) const;
+
+    Ring& ring_;
+    TraceWriter* recorder_;
+    std::map<NodeId, Node*> live_;   ///< Nodes in the ring by ID
+    TraceStats stats_;
+};
+
+#endif  // TRACE_H
@@ -0,0 +1,132 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @class SlabAllocator
+ * @brief Size-class slab allocator backing every stored value.
+ *
+ * Requests up to kMaxClassBytes are rounded up to a power of two and carved
+ * out of 64 KiB slabs; freed blocks go back to a per-class free list and are
+ * reused. Larger requests fall through to operator new. Slabs are only
+ * released when the allocator is destroyed.
+ */
+class SlabAllocator {
+public:
+    SlabAllocator();
+    ~SlabAllocator();
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    /**
+     * @brief The process-wide allocator used by Blob.
+     */
+    static SlabAllocator& instance();
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+
+    /**
+     * @brief Bytes currently handed out (after size-class rounding).
+     */
+    size_t bytesInUse() const { return bytesInUse_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Bytes reserved from the system for slabs.
+     */
+    size_t bytesReserved() const { return slabCount_.load(std::memory_order_relaxed) * kSlabBytes; }
+
+private:
+    static const size_t kMinClassBytes = 16;
+    static const size_t kMaxClassBytes = 4096;
+    static const int kNumClasses = 9;          // 16, 32, ..., 4096
+    static const size_t kSlabBytes = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static int sizeClass(size_t bytes);
+    void refill(int cls);
+
+    FreeBlock* freeLists_[kNumClasses];   ///< Free blocks per size class
+    std::vector<char*> slabs_;            ///< Every slab obtained so far
+    // Counters are updated under lock_ but read without it, e.g. while Ring::load
+    // allocates from several threads
+    std::atomic<size_t> bytesInUse_;
+    std::atomic<size_t> slabCount_;
+    std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+};
+
+/**
+ * @class Blob
+ * @brief Move-only byte buffer allocated from the SlabAllocator.
+ *
+ * Moving a Blob hands over the buffer; use clone() for an explicit deep copy.
+ */
+class Blob {
+public:
+    Blob() : data_(nullptr), size_(0) {}
+    Blob(const void* bytes, size_t size);
+    explicit Blob(const std::string& text) : Blob(text.data(), text.size()) {}
+    ~Blob() { release(); }
+
+    Blob(Blob&& other) noexcept : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    Blob& operator=(Blob&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+    Blob(const Blob&) = delete;
+    Blob& operator=(const Blob&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    Blob clone() const { return Blob(data_, size_); }
+    std::string str() const { return std::string((const char*)data_, size_); }
+
+    /**
+     * @brief The bytes as text when printable, otherwise as 0x-prefixed hex.
+     */
+    std::string toDisplayString() const;
+
+private:
+    void release();
+
+    uint8_t* data_;
+    size_t size_;
+};
+
+typedef std::optional<Blob> Value;   ///< Stored value; std::nullopt means "None"
+
+/**
+ * @brief Printable form of a stored value ("None" when absent).
+ */
+inline std::string valueToString(const Value& value) {
+    return value ? value->toDisplayString() : "None";
+}
+
+/**
+ * @brief Deep copy of a stored value (Blob itself only moves).
+ */
+inline Value cloneValue(const Value& value) {
+    return value ? Value(value->clone()) : Value();
+}
+
+#endif  // VALUE_H
@@ -0,0 +1,646 @@
+#include "actor_runtime.h"
+#include "log.h"
+#include "node.h"
+#include "ring.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+const uint32_t kActorBatch = 64;   // Messages an actor handles before yielding its worker
+const size_t kInjectBatch = 32;    // Injected actors a worker takes at once
+const int kIdleSpins = 64;         // Empty polls before a worker sleeps
+
+// Worker identity of the current thread, so sends from a worker stay on its own deque
+thread_local ActorRuntime* currentRuntime = nullptr;
+thread_local unsigned currentWorker = 0;
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Mailbox
+// ---------------------------------------------------------------------------
+
+Mailbox::Mailbox() : head_(&stub_), tail_(&stub_) {
+    stub_.next.store(nullptr, std::memory_order_relaxed);
+}
+
+void Mailbox::push(ActorMessage* message) {
+    message->next.store(nullptr, std::memory_order_relaxed);
+    ActorMessage* prev = head_.exchange(message, std::memory_order_acq_rel);
+    prev->next.store(message, std::memory_order_release);
+}
+
+ActorMessage* Mailbox::pop() {
+    ActorMessage* tail = tail_;
+    ActorMessage* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_) {
+        if (!next) return nullptr;
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+
+    // tail is the last linked message; a producer may be between its two steps
+    if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+
+    // Re-insert the stub behind tail so tail can be handed out
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// WorkStealingDeque
+// ---------------------------------------------------------------------------
+
+WorkStealingDeque::WorkStealingDeque(size_t capacity) : top_(0), bottom_(0) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    buffer_.reset(new std::atomic<NodeHandle>[size]);
+    mask_ = (int64_t)size - 1;
+}
+
+void WorkStealingDeque::push(NodeHandle handle) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    buffer_[b & mask_].store(handle, std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_release);
+}
+
+bool WorkStealingDeque::pop(NodeHandle& handle) {
+    // Sequentially consistent so a thief and the owner never both take the last entry
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_seq_cst);
+
+    if (t > b) {
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    handle = buffer_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last entry: race the thieves for it
+        bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool WorkStealingDeque::steal(NodeHandle& handle) {
+    int64_t t = top_.load(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_seq_cst);
+    if (t >= b) return false;
+
+    handle = buffer_[t & mask_].load(std::memory_order_relaxed);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// ActorRuntime: scheduling
+// ---------------------------------------------------------------------------
+
+ActorRuntime::ActorRuntime(Ring& ring, unsigned threads)
+    : ring_(ring),
+      actorCount_(ring.size()),
+      actors_(new Actor[ring.size() > 0 ? ring.size() : 1]),
+      hasInjected_(false),
+      sleeping_(0),
+      stop_(false)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    sent_.reset(new Counter[threads + 1]);
+    processed_.reset(new Counter[threads]);
+    for (unsigned i = 0; i < threads; ++i) {
+        deques_.emplace_back(new WorkStealingDeque(std::max<size_t>(actorCount_, 1)));
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back(&ActorRuntime::workerLoop, this, i);
+    }
+}
+
+ActorRuntime::~ActorRuntime() {
+    waitIdle();
+    stop_.store(true);
+    idleCv_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+ActorMessage* ActorRuntime::newMessage(MsgType type, NodeHandle src) {
+    ActorMessage* message = new ActorMessage();
+    message->lookupOut = nullptr;
+    message->getOut = nullptr;
+    message->keys = nullptr;
+    message->src = src;
+    message->arg = kNullHandle;
+    message->hops = 0;
+    message->type = type;
+    message->purpose = ForLookup;
+    message->finger = 0;
+    return message;
+}
+
+void ActorRuntime::send(NodeHandle dst, ActorMessage* message) {
+    // Counted before the push, so waitIdle() never sees it processed but not sent
+    unsigned slot = currentRuntime == this ? currentWorker : (unsigned)workers_.size();
+    sent_[slot].value.fetch_add(1, std::memory_order_relaxed);
+
+    // Counted before it is visible, so the consumer never takes more than pending
+    Actor& actor = actors_[dst];
+    bool wasIdle = actor.pending.fetch_add(1, std::memory_order_acq_rel) == 0;
+    actor.mailbox.push(message);
+    if (wasIdle) schedule(dst);
+}
+
+void ActorRuntime::schedule(NodeHandle handle) {
+    if (currentRuntime == this) {
+        deques_[currentWorker]->push(handle);
+    } else {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        injected_.push_back(handle);
+        hasInjected_.store(true, std::memory_order_release);
+    }
+    if (sleeping_.load(std::memory_order_relaxed) > 0) {
+        idleCv_.notify_one();
+    }
+}
+
+bool ActorRuntime::findWork(unsigned index, NodeHandle& handle) {
+    if (deques_[index]->pop(handle)) return true;
+
+    if (hasInjected_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        size_t take = std::min(injected_.size(), kInjectBatch);
+        if (take > 0) {
+            // Keep one, queue the rest locally where other workers can steal them
+            for (size_t i = 1; i < take; ++i) {
+                deques_[index]->push(injected_[injected_.size() - 1 - i]);
+            }
+            handle = injected_.back();
+            injected_.resize(injected_.size() - take);
+            if (injected_.empty()) hasInjected_.store(false, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    const unsigned count = (unsigned)deques_.size();
+    for (unsigned k = 1; k < count; ++k) {
+        if (deques_[(index + k) % count]->steal(handle)) return true;
+    }
+    return false;
+}
+
+void ActorRuntime::workerLoop(unsigned index) {
+    currentRuntime = this;
+    currentWorker = index;
+
+    int idle = 0;
+    while (!stop_.load(std::memory_order_relaxed)) {
+        NodeHandle handle;
+        if (findWork(index, handle)) {
+            runActor(handle, index);
+            idle = 0;
+        } else if (++idle < kIdleSpins) {
+            std::this_thread::yield();
+        } else {
+            // Sleep; the timeout bounds the delay of a missed notification
+            std::unique_lock<std::mutex> lock(idleMutex_);
+            sleeping_.fetch_add(1);
+            idleCv_.wait_for(lock, std::chrono::milliseconds(1));
+            sleeping_.fetch_sub(1);
+        }
+    }
+}
+
+void ActorRuntime::runActor(NodeHandle handle, unsigned index) {
+    Actor& actor = actors_[handle];
+    Node* node = ring_.node(handle);
+
+    uint32_t done = 0;
+    while (done < kActorBatch) {
+        ActorMessage* message = actor.mailbox.pop();
+        if (!message) break;
+        this->handle(node, message);
+        done++;
+    }
+
+    if (done > 0) processed_[index].value.fetch_add(done, std::memory_order_release);
+
+    // Only the transition to zero releases the actor; otherwise it stays ours
+    uint32_t left = actor.pending.fetch_sub(done, std::memory_order_acq_rel) - done;
+    if (left > 0) {
+        if (done == 0) std::this_thread::yield();   // A producer has not pushed yet
+        deques_[index]->push(handle);
+    }
+}
+
+void ActorRuntime::waitIdle() {
+    int spins = 0;
+    while (true) {
+        // Processed first: anything counted there was sent, and whatever it
+        // sent was counted, before it was processed
+        uint64_t processed = 0;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            processed += processed_[i].value.load(std::memory_order_acquire);
+        }
+        uint64_t sent = 0;
+        for (size_t i = 0; i <= workers_.size(); ++i) {
+            sent += sent_[i].value.load(std::memory_order_acquire);
+        }
+        if (processed == sent) return;
+
+        if (++spins < kIdleSpins) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+uint64_t ActorRuntime::messagesProcessed() const {
+    uint64_t processed = 0;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        processed += processed_[i].value.load(std::memory_order_acquire);
+    }
+    return processed;
+}
+
+// ---------------------------------------------------------------------------
+// ActorRuntime: requests
+// ---------------------------------------------------------------------------
+
+void ActorRuntime::lookup(Node* origin, NodeId key, LookupResult* out) {
+    ActorMessage* message = newMessage(Route, origin->getHandle());
+    message->key = key;
+    message->purpose = ForLookup;
+    message->lookupOut = out;
+    send(origin->getHandle(), message);
+}
+
+void ActorRuntime::insert(Node* origin, NodeId key, Value value) {
+    ActorMessage* message = newMessage(Route, origin->getHandle());
+    message->key = key;
+    message->value = std::move(value);
+    message->purpose = ForInsert;
+    send(origin->getHandle(), message);
+}
+
+void ActorRuntime::get(Node* origin, NodeId key, ActorGetResult* out) {
+    ActorMessage* message = newMessage(Route, origin->getHandle());
+    message->key = key;
+    message->purpose = ForGet;
+    message->getOut = out;
+    send(origin->getHandle(), message);
+}
+
+void ActorRuntime::join(Node* node, Node* knownNode) {
+    if (knownNode == nullptr) {
+        // First node: its own successor
+        ActorMessage* message = newMessage(JoinReply, node->getHandle());
+        message->arg = node->getHandle();
+        send(node->getHandle(), message);
+        return;
+    }
+    ActorMessage* message = newMessage(Route, node->getHandle());
+    message->key = node->getId();
+    message->purpose = ForJoin;
+    send(knownNode->getHandle(), message);
+}
+
+void ActorRuntime::leave(Node* node) {
+    send(node->getHandle(), newMessage(LeaveTick, node->getHandle()));
+}
+
+void ActorRuntime::stabilize() {
+    for (size_t h = 0; h < actorCount_; ++h) {
+        send((NodeHandle)h, newMessage(StabilizeTick, (NodeHandle)h));
+    }
+}
+
+void ActorRuntime::fixFingers() {
+    for (size_t h = 0; h < actorCount_; ++h) {
+        send((NodeHandle)h, newMessage(FixFingersTick, (NodeHandle)h));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ActorRuntime: protocol (runs on the actor of `node`; touches only its state)
+// ---------------------------------------------------------------------------
+
+void ActorRuntime::handle(Node* node, ActorMessage* message) {
+    switch (message->type) {
+        case Route:
+            onRoute(node, message);
+            return;
+
+        case Resolve:
+            if (hasLeft(node)) {
+                send(node->successor_->handle_, message);
+                return;
+            }
+            deliver(node, node, message);
+            return;
+
+        case Store:
+            if (forwardToOwner(node, message)) return;
+            node->localKeys_.put(message->key, std::move(message->value));
+            break;
+
+        case Read: {
+            if (forwardToOwner(node, message)) return;
+            const Value* stored = node->localKeys_.find(message->key);
+            ActorGetResult* out = message->getOut;
+            out->found = stored != nullptr;
+            if (stored && stored->has_value()) out->value = Value(stored->value().clone());
+            out->node = node;
+            break;
+        }
+
+        case FingerReply:
+            node->fingerTable_.set(message->finger, ring_.node(message->arg));
+            break;
+
+        case JoinReply: {
+            Node* successor = ring_.node(message->arg);
+            node->successor_ = successor;
+            node->predecessor_ = nullptr;
+            node->inRing_ = true;
+            for (int i = 1; i <= BITLENGTH; i++) {
+                node->fingerTable_.set(i, successor);
+            }
+            DHT_LOG_INFO("Node " << idToString(node->id_) << " joined with successor Node "
+                         << idToString(successor->id_));
+            if (successor != node) {
+                // Announce ourselves right away so the successor hands over our keys
+                message->type = Notify;
+                message->src = node->handle_;
+                send(successor->handle_, message);
+                return;
+            }
+            break;
+        }
+
+        case StabilizeTick:
+            if (node->inRing_) {
+                // Also ask the predecessor whether it is still there
+                if (node->predecessor_ && node->predecessor_ != node) {
+                    send(node->predecessor_->handle_, newMessage(CheckPredecessor, node->handle_));
+                }
+                message->type = GetPredecessor;
+                message->src = node->handle_;
+                send(node->successor_->handle_, message);
+                return;
+            }
+            break;
+
+        case GetPredecessor: {
+            NodeHandle requester = message->src;
+            message->src = node->handle_;
+            if (hasLeft(node)) {
+                // Point the requester past us
+                message->type = SuccessorLeft;
+                message->arg = node->successor_->handle_;
+            } else {
+                message->type = PredecessorReply;
+                message->arg = node->predecessor_ ? node->predecessor_->handle_ : kNullHandle;
+            }
+            send(requester, message);
+            return;
+        }
+
+        case CheckPredecessor:
+            if (hasLeft(node)) {
+                NodeHandle requester = message->src;
+                message->type = PredecessorLeft;
+                message->src = node->handle_;
+                message->arg = node->predecessor_ ? node->predecessor_->handle_ : kNullHandle;
+                send(requester, message);
+                return;
+            }
+            break;
+
+        case PredecessorReply:
+            onPredecessorReply(node, message);
+            return;
+
+        case Notify:
+            onNotify(node, message);
+            return;
+
+        case TransferKeys:
+            if (hasLeft(node)) {
+                send(node->successor_->handle_, message);   // Left in the meantime
+                return;
+            }
+            // (x, x] selects every key
+            message->keys->moveInterval(node->id_, node->id_, node->localKeys_);
+            delete message->keys;
+            break;
+
+        case FixFingersTick:
+            if (node->inRing_) {
+                for (int i = 1; i <= BITLENGTH; i++) {
+                    ActorMessage* lookup = newMessage(Route, node->handle_);
+                    lookup->key = ChordSpace::fingerStart(node->id_, i);
+                    lookup->purpose = ForFinger;
+                    lookup->finger = (uint8_t)i;
+                    onRoute(node, lookup);
+                }
+            }
+            break;
+
+        case LeaveTick:
+            onLeave(node);
+            break;
+
+        case PredecessorLeft:
+            if (hasLeft(node)) {
+                // Our successor inherits the keys and, if it still points here, our predecessor
+                send(node->successor_->handle_, message);
+                return;
+            }
+            if (message->keys) {
+                message->keys->moveInterval(node->id_, node->id_, node->localKeys_);
+                delete message->keys;
+            }
+            if (node->predecessor_ && node->predecessor_->handle_ == message->src) {
+                Node* replacement = message->arg == kNullHandle ? nullptr : ring_.node(message->arg);
+                node->predecessor_ = replacement == node ? nullptr : replacement;
+            }
+            break;
+
+        case SuccessorLeft:
+            if (node->successor_->handle_ == message->src) {
+                node->successor_ = ring_.node(message->arg);
+            }
+            break;
+    }
+    delete message;
+}
+
+// Left the ring, but still knows where it was: messages are passed on along successor_
+bool ActorRuntime::hasLeft(const Node* node) {
+    return !node->inRing_ && node->successor_ != node;
+}
+
+// One routing step of find_successor (same rules as Node::lookup)
+void ActorRuntime::onRoute(Node* node, ActorMessage* message) {
+    if (!node->inRing_ && node->successor_ == node) {
+        // Never joined (or left as the last node): nobody to ask
+        DHT_LOG_WARN("Node " << idToString(node->id_) << " is not in the ring; dropped request for key "
+                     << idToString(message->key));
+        delete message;
+        return;
+    }
+
+    if (hasLeft(node)) {
+        // A departed node still routes forward, but its own former range and
+        // the one up to its successor belong to the first node after it that
+        // is still in the ring (its successor may have left too)
+        NodeId from = node->predecessor_ ? node->predecessor_->id_ : node->id_;
+        if (message->key == node->id_ ||
+            node->inInterval(message->key, from, node->successor_->id_, false, true)) {
+            message->type = Resolve;
+            send(node->successor_->handle_, message);
+            return;
+        }
+    }
+
+    Node* responsible = nullptr;
+    if (message->key == node->id_ && node->inRing_) {
+        responsible = node;
+    } else if (node->inInterval(message->key, node->id_, node->successor_->id_, false, true)) {
+        responsible = node->successor_;
+    }
+    if (responsible) {
+        deliver(node, responsible, message);
+        return;
+    }
+
+    Node* next = node->closest_preceding_finger(message->key);
+    if (next == node) next = node->successor_;
+    message->hops++;
+    send(next->handle_, message);
+}
+
+void ActorRuntime::deliver(Node* node, Node* responsible, ActorMessage* message) {
+    (void)node;
+    switch (message->purpose) {
+        case ForLookup:
+            message->lookupOut->node = responsible;
+            message->lookupOut->hops = message->hops;
+            delete message;
+            return;
+        case ForInsert:
+            message->type = Store;
+            send(responsible->handle_, message);
+            return;
+        case ForGet:
+            message->type = Read;
+            send(responsible->handle_, message);
+            return;
+        case ForFinger:
+            message->type = FingerReply;
+            break;
+        case ForJoin:
+            message->type = JoinReply;
+            break;
+    }
+    // Back to the node that asked
+    message->arg = responsible->handle_;
+    send(message->src, message);
+}
+
+// A store or read reached a node that no longer owns the key: pass it on
+bool ActorRuntime::forwardToOwner(Node* node, ActorMessage* message) {
+    if (hasLeft(node)) {
+        send(node->successor_->handle_, message);
+        return true;
+    }
+    // A node that joined behind us has not been reached by its predecessor yet
+    Node* predecessor = node->predecessor_;
+    if (predecessor && predecessor != node &&
+        !node->inInterval(message->key, predecessor->id_, node->id_, false, true)) {
+        send(predecessor->handle_, message);
+        return true;
+    }
+    return false;
+}
+
+// stabilize(), step 2: adopt the successor's predecessor if closer, then notify
+void ActorRuntime::onPredecessorReply(Node* node, ActorMessage* message) {
+    if (!node->inRing_) {
+        delete message;
+        return;
+    }
+    // Only trust the answer if it came from the current successor
+    if (message->arg != kNullHandle && node->successor_->handle_ == message->src) {
+        Node* x = ring_.node(message->arg);
+        if (x != node && (node->successor_ == node ||
+                          node->inInterval(x->id_, node->id_, node->successor_->id_, false, false))) {
+            node->successor_ = x;
+        }
+    }
+    message->type = Notify;
+    message->src = node->handle_;
+    send(node->successor_->handle_, message);
+}
+
+// notify(): adopt the sender as predecessor and hand over the keys it now owns
+void ActorRuntime::onNotify(Node* node, ActorMessage* message) {
+    Node* n = ring_.node(message->src);
+    Node* old = node->predecessor_;
+    if (!node->inRing_ || n == node || n == old ||
+        (old && !node->inInterval(n->id_, old->id_, node->id_, false, false))) {
+        delete message;
+        return;
+    }
+    node->predecessor_ = n;
+
+    // Keys in (old predecessor, n] now belong to n; without one, everything outside (n, this]
+    KeyStore<Value>* moved = new KeyStore<Value>();
+    node->localKeys_.moveInterval(old ? old->id_ : node->id_, n->id_, *moved);
+    if (moved->empty()) {
+        delete moved;
+        delete message;
+        return;
+    }
+    message->type = TransferKeys;
+    message->keys = moved;
+    message->src = node->handle_;
+    send(n->handle_, message);
+}
+
+void ActorRuntime::onLeave(Node* node) {
+    if (!node->inRing_) return;
+    DHT_LOG_INFO("Node " << idToString(node->id_) << " is leaving the ring.");
+    node->inRing_ = false;
+    if (node->successor_ == node) return;   // Last node
+
+    // Successor takes the keys and our predecessor; (id, id] selects every key
+    ActorMessage* toSuccessor = newMessage(PredecessorLeft, node->handle_);
+    toSuccessor->keys = new KeyStore<Value>();
+    node->localKeys_.moveInterval(node->id_, node->id_, *toSuccessor->keys);
+    toSuccessor->arg = node->predecessor_ ? node->predecessor_->handle_ : kNullHandle;
+    send(node->successor_->handle_, toSuccessor);
+
+    if (node->predecessor_) {
+        ActorMessage* toPredecessor = newMessage(SuccessorLeft, node->handle_);
+        toPredecessor->arg = node->successor_->handle_;
+        send(node->predecessor_->handle_, toPredecessor);
+    }
+}
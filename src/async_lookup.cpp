@@ -0,0 +1,117 @@
+#include "async_lookup.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#include "log.h"
+
+AsyncScheduler::~AsyncScheduler() {
+    for (std::coroutine_handle<> handle : pending_) handle.destroy();
+}
+
+void AsyncScheduler::prefetch(const Node* node, bool fingers) {
+#if defined(__GNUC__)
+    // The ID and liveness flag, and for the next hop the finger IDs and the successor
+    __builtin_prefetch(&node->id_);
+    __builtin_prefetch(&node->inRing_);
+    if (!fingers) return;
+    const char* begin = (const char*)&node->fingerTable_.getId(0);
+    const char* end = (const char*)(&node->fingerTable_.getId(BITLENGTH) + 1);
+    for (const char* p = begin; p < end; p += 64) __builtin_prefetch(p);
+    __builtin_prefetch(&node->successor_);
+#else
+    (void)node;
+    (void)fingers;
+#endif
+}
+
+// Same routing as Node::lookup(). Each hop yields twice: once while the successor and
+// the chosen finger are fetched, once while the next node's finger table is.
+Task<LookupResult> AsyncScheduler::lookup(Node* origin, NodeId key) {
+    LookupResult result;
+    Node* current = origin;
+    while (true) {
+        if (key == current->id_) {
+            result.node = current;
+            break;
+        }
+
+        // The successor and the closest preceding finger are read next
+        int finger = current->fingerTable_.closestPreceding(current->id_, key);
+        prefetch(current->successor_, false);
+        if (finger) prefetch(current->fingerTable_.get(finger), false);
+        co_await yield();
+
+        Node* successor = current->liveSuccessor();
+        if (!successor) break;   // Every known successor failed
+        if (successor != current->successor_) result.timeouts++;
+
+        if (origin->inInterval(key, current->id_, successor->id_, false, true)) {
+            result.node = successor;
+            break;
+        }
+
+        // The finger found above, unless it failed (then as closest_preceding_live())
+        Node* next = finger ? current->fingerTable_.get(finger) : current;
+        if (next != current && !next->inRing_) next = current->closest_preceding_live(key, result.timeouts);
+        if (next == current) next = successor;
+
+        prefetch(next, true);
+        co_await yield();
+        current = next;
+        result.hops++;
+    }
+    DHT_METRIC(origin->recordLookup(result));
+    co_return result;
+}
+
+Task<Node*> AsyncScheduler::insert(Node* origin, NodeId key, Value value) {
+    LookupResult result = co_await lookup(origin, key);
+    Node* responsible = result.node;
+    if (!responsible) {
+        DHT_LOG_WARN("Key " << idToString(key) << " not stored: no live node responsible was found");
+        co_return nullptr;
+    }
+    responsible->requestsServed_++;
+    responsible->dropInTransit(key);
+    responsible->localKeys_.put(key, std::move(value));
+    if (REPLICATION_FACTOR > 1) responsible->replicate(key, *responsible->localKeys_.find(key));
+    co_return responsible;
+}
+
+std::future<LookupResult> AsyncScheduler::submitLookup(Node* origin, NodeId key) {
+    std::promise<LookupResult> promise;
+    std::future<LookupResult> future = promise.get_future();
+    spawn(lookup(origin, key), [promise = std::move(promise)](LookupResult&& result) mutable {
+        promise.set_value(std::move(result));
+    });
+    return future;
+}
+
+std::future<Node*> AsyncScheduler::submitInsert(Node* origin, NodeId key, Value value) {
+    std::promise<Node*> promise;
+    std::future<Node*> future = promise.get_future();
+    spawn(insert(origin, key, std::move(value)), [promise = std::move(promise)](Node* node) mutable {
+        promise.set_value(node);
+    });
+    return future;
+}
+
+size_t AsyncScheduler::run() {
+    size_t before = completed_;
+    while (!pending_.empty() || !ready_.empty()) {
+        // Top up the window, then give every request in flight one step
+        while (!pending_.empty() && (window_ == 0 || active_ < window_)) {
+            ready_.push_back(pending_.front());
+            pending_.pop_front();
+            active_++;
+        }
+        for (size_t n = ready_.size(); n > 0; --n) {
+            std::coroutine_handle<> handle = ready_.front();
+            ready_.pop_front();
+            handle.resume();
+        }
+    }
+    return completed_ - before;
+}
+
+#endif  // __cpp_impl_coroutine
@@ -1,18 +1,25 @@
 #include "finger_table.h"
 #include "node.h"
+#include "node_pool.h"
 #include <iostream>
+#include <type_traits>
 
 /**
  * @brief Constructor: Initializes an empty finger table.
  */
-FingerTable::FingerTable(Node* owner) : owner_(owner), fingers_(BITLENGTH + 1, nullptr) {}
+FingerTable::FingerTable(Node* owner) : owner_(owner) {
+    for (int i = 0; i <= BITLENGTH; i++) {
+        ids_[i] = owner->getId();
+        fingers_[i] = kNullHandle;
+    }
+}
 
 /**
  * @brief Get the node at index i in the finger table.
  */
 Node* FingerTable::get(int i) const {
-    if (i >= 1 && i <= BITLENGTH) {
-        return fingers_[i];
+    if (i >= 1 && i <= BITLENGTH && fingers_[i] != kNullHandle) {
+        return owner_->getPool()->get(fingers_[i]);
     }
     return nullptr;
 }
@@ -22,7 +29,51 @@ Node* FingerTable::get(int i) const {
  */
 void FingerTable::set(int i, Node* node) {
     if (i >= 1 && i <= BITLENGTH) {
-        fingers_[i] = node;
+        fingers_[i] = node ? node->getHandle() : kNullHandle;
+        ids_[i] = node ? node->getId() : owner_->getId();
+    }
+}
+
+void FingerTable::set(int i, NodeHandle handle, const NodeId& id) {
+    if (i >= 1 && i <= BITLENGTH) {
+        fingers_[i] = handle;
+        ids_[i] = handle != kNullHandle ? id : owner_->getId();
+    }
+}
+
+/**
+ * @brief Pick the closest preceding finger from the cached IDs.
+ */
+int FingerTable::closestPreceding(const NodeId& ownerId, const NodeId& key) const {
+    if (key == ownerId) return 0;  // (owner, owner) is empty
+
+    if constexpr (std::is_integral<NodeId>::value) {
+        // x in (owner, key)  <=>  0 < d(x) < d(key)  <=>  d(x) - 1 < d(key) - 1,
+        // with d() the clockwise distance from the owner. Unset entries hold the
+        // owner's ID (d = 0), which wraps to the maximum and never matches.
+        //
+        // Entries are scanned from the top in blocks of kBlock: each block is a
+        // branchless max-reduction the compiler vectorizes, and the scan stops
+        // at the first block with a match, so usually only the last cache line
+        // of ids_ is read.
+        const int kBlock = 64 / (int)sizeof(NodeId) > 0 ? 64 / (int)sizeof(NodeId) : 1;
+        const NodeId limit = ChordSpace::sub(ChordSpace::distance(ownerId, key), 1);
+        for (int hi = BITLENGTH; hi >= 1; hi -= kBlock) {
+            int lo = hi - kBlock + 1 > 1 ? hi - kBlock + 1 : 1;
+            int best = 0;
+            for (int i = lo; i <= hi; i++) {
+                NodeId d = ChordSpace::sub(ChordSpace::distance(ownerId, ids_[i]), 1);
+                int candidate = d < limit ? i : 0;
+                best = best > candidate ? best : candidate;
+            }
+            if (best) return best;
+        }
+        return 0;
+    } else {
+        for (int i = BITLENGTH; i >= 1; i--) {
+            if (ChordSpace::inInterval(ids_[i], ownerId, key, false, false)) return i;
+        }
+        return 0;
     }
 }
 
@@ -31,8 +82,8 @@ void FingerTable::set(int i, Node* node) {
  */
 void FingerTable::initialize() {
     for (int i = 1; i <= BITLENGTH; i++) {
-        uint16_t start = (owner_->getId() + (1 << (i - 1))) % (1 << BITLENGTH);
-        fingers_[i] = owner_->find_successor(start);
+        NodeId start = ChordSpace::fingerStart(owner_->getId(), i);
+        set(i, owner_->find_successor(start));
     }
 }
 
@@ -41,16 +92,16 @@ void FingerTable::initialize() {
  */
 void FingerTable::prettyPrint() {
     std::cout << "------------------------------\n";
-    std::cout << "Finger Table of Node " << (int)owner_->getId() << ":\n";
+    std::cout << "Finger Table of Node " << idToString(owner_->getId()) << ":\n";
     std::cout << "  (Each entry k = i is calculated as: start = (ID + 2^(i-1)) mod " 
-              << (1 << BITLENGTH) << ")\n";
+              << ChordSpace::ringSizeString() << ")\n";
     for (size_t i = 1; i <= BITLENGTH; ++i) {
-        uint16_t start = (owner_->getId() + (1 << (i - 1))) % (1 << BITLENGTH);
-        if (fingers_[i]) {
-            std::cout << "  k = " << i << " (start = " << start << ") : Node "
-                      << (int)fingers_[i]->getId() << "\n";
+        NodeId start = ChordSpace::fingerStart(owner_->getId(), i);
+        if (Node* finger = get(i)) {
+            std::cout << "  k = " << i << " (start = " << idToString(start) << ") : Node "
+                      << idToString(finger->getId()) << "\n";
         } else {
-            std::cout << "  k = " << i << " (start = " << start << ") : None\n";
+            std::cout << "  k = " << i << " (start = " << idToString(start) << ") : None\n";
         }
     }
     std::cout << "------------------------------\n";
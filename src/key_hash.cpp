@@ -0,0 +1,280 @@
+#include "key_hash.h"
+#include <string.h>
+#include <algorithm>
+
+// Rotate left; works on scalars and on GCC/Clang vectors alike
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+namespace {
+
+const uint32_t kSha1Init[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u};
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+inline uint32_t loadBe32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+inline uint32_t loadLe32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint64_t loadLe64(const uint8_t* p) {
+    return (uint64_t)loadLe32(p) | ((uint64_t)loadLe32(p + 4) << 32);
+}
+
+inline uint64_t rotl64(uint64_t x, int n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+// Number of 64-byte blocks after SHA-1 padding (0x80, zeros, 64-bit length)
+inline size_t sha1Blocks(size_t size) {
+    return (size + 8) / 64 + 1;
+}
+
+// Block b of the padded message
+void sha1Block(const uint8_t* data, size_t size, size_t b, uint8_t block[64]) {
+    size_t offset = b * 64;
+    size_t n = offset < size ? std::min<size_t>(64, size - offset) : 0;
+    memcpy(block, data + offset, n);
+    memset(block + n, 0, 64 - n);
+    if (offset <= size && size < offset + 64) block[size - offset] = 0x80;
+    if (b + 1 == sha1Blocks(size)) {
+        uint64_t bits = (uint64_t)size * 8;
+        for (int i = 0; i < 8; ++i) block[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+}
+
+// One SHA-1 compression. V is uint32_t for one message, or a vector of
+// uint32_t holding the same word of several messages (one per lane).
+template <typename V>
+void sha1Compress(V h[5], const V block[16]) {
+    V w[80];
+    for (int t = 0; t < 16; ++t) w[t] = block[t];
+    for (int t = 16; t < 80; ++t) w[t] = ROTL32(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+
+    V a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int t = 0; t < 80; ++t) {
+        V f;
+        uint32_t k;
+        if (t < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999u;
+        } else if (t < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1u;
+        } else if (t < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDCu;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6u;
+        }
+        V temp = ROTL32(a, 5) + f + e + k + w[t];
+        e = d;
+        d = c;
+        c = ROTL32(b, 30);
+        b = a;
+        a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+void sha1Digest(const uint32_t h[5], uint8_t digest[20]) {
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 4; ++j) digest[4 * i + j] = (uint8_t)(h[i] >> (24 - 8 * j));
+    }
+}
+
+// Top BITLENGTH bits of a big-endian digest of at least 20 bytes
+NodeId idFromDigest(const uint8_t* digest) {
+#if BITLENGTH == 160
+    return Uint160::fromBytes(digest);
+#else
+    uint64_t top = 0;
+    for (int i = 0; i < 8; ++i) top = (top << 8) | digest[i];
+    return (NodeId)(top >> (64 - BITLENGTH));
+#endif
+}
+
+NodeId xxhId(const void* data, size_t size) {
+#if BITLENGTH == 160
+    uint8_t bytes[24];
+    for (int s = 0; s < 3; ++s) {
+        uint64_t h = xxh64(data, size, (uint64_t)s);
+        for (int i = 0; i < 8; ++i) bytes[8 * s + i] = (uint8_t)(h >> (56 - 8 * i));
+    }
+    return idFromDigest(bytes);
+#else
+    return (NodeId)(xxh64(data, size, 0) >> (64 - BITLENGTH));
+#endif
+}
+
+#if defined(__GNUC__)
+
+const int kLanes = 8;
+const size_t kMaxLaneBlocks = 4;   // Longer keys are hashed one by one
+typedef uint32_t LaneWord __attribute__((vector_size(4 * kLanes)));
+
+// Hashes keys[idx[0..count)], all with `blocks` padded blocks, one per lane
+void sha1Lanes(const std::vector<std::string>& keys, const uint32_t* idx, int count, size_t blocks,
+               NodeId* out) {
+    LaneWord h[5];
+    for (int i = 0; i < 5; ++i) h[i] = LaneWord{} + kSha1Init[i];
+
+    uint8_t block[64];
+    uint32_t words[16][kLanes];
+    for (size_t b = 0; b < blocks; ++b) {
+        // Transpose: word t of lane l's block goes to lane l of vector t
+        for (int l = 0; l < kLanes; ++l) {
+            const std::string& key = keys[idx[std::min(l, count - 1)]];   // Idle lanes repeat a key
+            sha1Block((const uint8_t*)key.data(), key.size(), b, block);
+            for (int t = 0; t < 16; ++t) words[t][l] = loadBe32(block + 4 * t);
+        }
+        LaneWord w[16];
+        memcpy(w, words, sizeof(w));
+        sha1Compress(h, w);
+    }
+
+    for (int l = 0; l < count; ++l) {
+        uint32_t lane[5];
+        for (int i = 0; i < 5; ++i) lane[i] = h[i][l];
+        uint8_t digest[20];
+        sha1Digest(lane, digest);
+        out[idx[l]] = idFromDigest(digest);
+    }
+}
+
+void sha1Batch(const std::vector<std::string>& keys, NodeId* out) {
+    // Bucket keys by padded length so every lane of a batch runs the same blocks
+    std::vector<uint32_t> byBlocks[kMaxLaneBlocks + 1];
+    for (size_t i = 0; i < keys.size(); ++i) {
+        size_t blocks = sha1Blocks(keys[i].size());
+        if (blocks <= kMaxLaneBlocks) {
+            byBlocks[blocks].push_back((uint32_t)i);
+        } else {
+            out[i] = hashKey(keys[i], KeyHash::Sha1);
+        }
+    }
+    for (size_t blocks = 1; blocks <= kMaxLaneBlocks; ++blocks) {
+        const std::vector<uint32_t>& idx = byBlocks[blocks];
+        for (size_t i = 0; i < idx.size(); i += kLanes) {
+            int count = (int)std::min<size_t>(kLanes, idx.size() - i);
+            sha1Lanes(keys, idx.data() + i, count, blocks, out);
+        }
+    }
+}
+
+#else
+
+void sha1Batch(const std::vector<std::string>& keys, NodeId* out) {
+    for (size_t i = 0; i < keys.size(); ++i) out[i] = hashKey(keys[i], KeyHash::Sha1);
+}
+
+#endif
+
+}  // namespace
+
+void sha1(const void* data, size_t size, uint8_t digest[20]) {
+    uint32_t h[5];
+    memcpy(h, kSha1Init, sizeof(h));
+    uint8_t block[64];
+    uint32_t w[16];
+    for (size_t b = 0, blocks = sha1Blocks(size); b < blocks; ++b) {
+        sha1Block((const uint8_t*)data, size, b, block);
+        for (int t = 0; t < 16; ++t) w[t] = loadBe32(block + 4 * t);
+        sha1Compress(h, w);
+    }
+    sha1Digest(h, digest);
+}
+
+uint64_t xxh64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+    auto round = [](uint64_t acc, uint64_t input) {
+        return rotl64(acc + input * kPrime2, 31) * kPrime1;
+    };
+    auto merge = [&](uint64_t acc, uint64_t v) {
+        return (acc ^ round(0, v)) * kPrime1 + kPrime4;
+    };
+
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = round(v1, loadLe64(p));
+            v2 = round(v2, loadLe64(p + 8));
+            v3 = round(v3, loadLe64(p + 16));
+            v4 = round(v4, loadLe64(p + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += (uint64_t)size;
+
+    for (; p + 8 <= end; p += 8) h = rotl64(h ^ round(0, loadLe64(p)), 27) * kPrime1 + kPrime4;
+    if (p + 4 <= end) {
+        h = rotl64(h ^ ((uint64_t)loadLe32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) h = rotl64(h ^ (*p * kPrime5), 11) * kPrime1;
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+NodeId hashKey(const void* data, size_t size, KeyHash hash) {
+    if (hash == KeyHash::Sha1) {
+        uint8_t digest[20];
+        sha1(data, size, digest);
+        return idFromDigest(digest);
+    }
+    return xxhId(data, size);
+}
+
+void hashKeys(const std::vector<std::string>& keys, NodeId* out, KeyHash hash) {
+    if (hash == KeyHash::Sha1) {
+        sha1Batch(keys, out);
+        return;
+    }
+    for (size_t i = 0; i < keys.size(); ++i) out[i] = xxhId(keys[i].data(), keys[i].size());
+}
+
+std::vector<NodeId> hashKeys(const std::vector<std::string>& keys, KeyHash hash) {
+    std::vector<NodeId> ids(keys.size());
+    hashKeys(keys, ids.data(), hash);
+    return ids;
+}
+
+std::vector<std::pair<NodeId, Value>> hashItems(std::vector<std::pair<std::string, Value>> items,
+                                                KeyHash hash) {
+    std::vector<std::string> keys;
+    keys.reserve(items.size());
+    for (auto& item : items) keys.push_back(std::move(item.first));
+    std::vector<NodeId> ids = hashKeys(keys, hash);
+
+    std::vector<std::pair<NodeId, Value>> hashed;
+    hashed.reserve(items.size());
+    for (size_t i = 0; i < items.size(); ++i) hashed.emplace_back(ids[i], std::move(items[i].second));
+    return hashed;
+}
@@ -0,0 +1,89 @@
+#include "location_cache.h"
+#include <algorithm>
+
+namespace {
+
+bool endLess(const std::pair<NodeId, uint32_t>& entry, const NodeId& key) {
+    return entry.first < key;
+}
+
+}  // namespace
+
+LocationCache::LocationCache(size_t capacity)
+    : slots_(std::max<size_t>(1, capacity), Slot{NodeId(), NodeId(), nullptr, 0, false}),
+      hand_(0)
+{
+    index_.reserve(slots_.size());
+    clear();
+}
+
+// The first range ending at or after key covers it, unless key is past every
+// end; then only a range wrapping past zero (the one with the smallest end) can.
+int LocationCache::indexOf(NodeId key) const {
+    if (index_.empty()) return -1;
+    size_t i = std::lower_bound(index_.begin(), index_.end(), key, endLess) - index_.begin();
+    if (i == index_.size()) i = 0;
+    const Slot& slot = slots_[index_[i].second];
+    return ChordSpace::inInterval(key, slot.start, slot.end, false, true) ? (int)i : -1;
+}
+
+Node* LocationCache::find(NodeId key, int& hops) {
+    int i = indexOf(key);
+    if (i < 0) return nullptr;
+    Slot& slot = slots_[index_[i].second];
+    slot.referenced = true;
+    hops = slot.hops;
+    return slot.owner;
+}
+
+// Only called with every slot in use
+uint32_t LocationCache::evict() {
+    while (true) {
+        Slot& slot = slots_[hand_];
+        uint32_t victim = (uint32_t)hand_;
+        hand_ = (hand_ + 1) % slots_.size();
+        if (slot.referenced) {
+            slot.referenced = false;   // Second chance
+            continue;
+        }
+        auto it = std::lower_bound(index_.begin(), index_.end(), slot.end, endLess);
+        index_.erase(it);
+        slot.owner = nullptr;
+        return victim;
+    }
+}
+
+void LocationCache::insert(NodeId start, NodeId end, Node* owner, int hops) {
+    auto it = std::lower_bound(index_.begin(), index_.end(), end, endLess);
+    uint32_t s;
+    if (it != index_.end() && it->first == end) {
+        s = it->second;
+    } else {
+        if (!free_.empty()) {
+            s = free_.back();
+            free_.pop_back();
+        } else {
+            s = evict();
+            it = std::lower_bound(index_.begin(), index_.end(), end, endLess);
+        }
+        index_.insert(it, std::make_pair(end, s));
+    }
+    slots_[s] = Slot{start, end, owner, (uint16_t)std::min(hops, 0xFFFF), false};
+}
+
+void LocationCache::erase(NodeId key) {
+    int i = indexOf(key);
+    if (i < 0) return;
+    uint32_t s = index_[i].second;
+    slots_[s].owner = nullptr;
+    free_.push_back(s);
+    index_.erase(index_.begin() + i);
+}
+
+void LocationCache::clear() {
+    for (Slot& slot : slots_) slot.owner = nullptr;
+    index_.clear();
+    free_.clear();
+    for (size_t s = slots_.size(); s-- > 0;) free_.push_back((uint32_t)s);
+    hand_ = 0;
+}
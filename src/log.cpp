@@ -0,0 +1,96 @@
+#include "log.h"
+#include <atomic>
+#include <iostream>
+
+namespace {
+
+StdoutSink defaultSink;
+std::atomic<LogSink*> currentSink(&defaultSink);
+std::atomic<int> runtimeLevel((int)LogLevel::Debug);
+
+}  // namespace
+
+void StdoutSink::write(LogLevel, const std::string& message) {
+    std::cout << message << '\n';
+}
+
+void StdoutSink::flush() {
+    std::cout.flush();
+}
+
+BufferedFileSink::BufferedFileSink(const std::string& path, size_t bufferBytes)
+    : file_(std::fopen(path.c_str(), "w")), bufferBytes_(bufferBytes) {
+    buffer_.reserve(bufferBytes_);
+}
+
+BufferedFileSink::~BufferedFileSink() {
+    flush();
+    if (file_) std::fclose(file_);
+}
+
+void BufferedFileSink::write(LogLevel, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_ += message;
+    buffer_ += '\n';
+    if (buffer_.size() >= bufferBytes_) flushLocked();
+}
+
+void BufferedFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushLocked();
+    if (file_) std::fflush(file_);
+}
+
+void BufferedFileSink::flushLocked() {
+    if (file_ && !buffer_.empty()) {
+        std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+    }
+    buffer_.clear();
+}
+
+RingBufferSink::RingBufferSink(size_t capacity)
+    : entries_(capacity > 0 ? capacity : 1), next_(0), total_(0) {}
+
+void RingBufferSink::write(LogLevel, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[next_] = message;
+    next_ = (next_ + 1) % entries_.size();
+    total_++;
+}
+
+std::vector<std::string> RingBufferSink::messages() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> out;
+    size_t count = total_ < entries_.size() ? total_ : entries_.size();
+    size_t first = (next_ + entries_.size() - count) % entries_.size();
+    for (size_t i = 0; i < count; i++) {
+        out.push_back(entries_[(first + i) % entries_.size()]);
+    }
+    return out;
+}
+
+size_t RingBufferSink::totalWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+}
+
+void Log::setSink(LogSink* sink) {
+    currentSink.store(sink ? sink : &defaultSink);
+}
+
+LogSink& Log::sink() {
+    return *currentSink.load();
+}
+
+void Log::setLevel(LogLevel level) {
+    runtimeLevel.store((int)level);
+}
+
+bool Log::enabled(LogLevel level) {
+    return (int)level <= runtimeLevel.load(std::memory_order_relaxed) &&
+           !currentSink.load(std::memory_order_relaxed)->discards();
+}
+
+void Log::write(LogLevel level, const std::string& message) {
+    currentSink.load()->write(level, message);
+}
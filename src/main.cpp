@@ -1,19 +1,19 @@
 #include <iostream>
 #include <cmath>
 #include "node.h"
-
-static const uint16_t RING_SIZE = (1 << BITLENGTH);
+#include "ring.h"
 
 int main() {
 
     std::cout << "\n========================= Task 1: Add nodes =========================\n";
-    // Create nodes
-    Node* n0 = new Node(0);
-    Node* n1 = new Node(30);
-    Node* n2 = new Node(65);
-    Node* n3 = new Node(110);
-    Node* n4 = new Node(160);
-    Node* n5 = new Node(230);
+    // Create nodes (owned by the ring)
+    Ring ring;
+    Node* n0 = ring.addNode(0);
+    Node* n1 = ring.addNode(30);
+    Node* n2 = ring.addNode(65);
+    Node* n3 = ring.addNode(110);
+    Node* n4 = ring.addNode(160);
+    Node* n5 = ring.addNode(230);
 
     // Join nodes
     n0->join(nullptr);
@@ -24,12 +24,12 @@ int main() {
     n5->join(n4);
 
     // Stabilize the network and finger tables
-    Node::stabilizeNetwork(n0);
-    Node::fixAllFingers(n0);
+    ring.stabilizeNetwork();
+    ring.fixAllFingers();
 
     // Print the ring structure and finger tables
     std::cout << "\n========================= Task 2: Print finger table of all nodes =========================\n";
-    Node::printAllFingerTables(n0);
+    ring.printAllFingerTables();
 
    // Insert keys into the Chord ring
    std::cout << "\n========================= Task 3: Inserting Keys =========================\n";
@@ -48,21 +48,21 @@ int main() {
 
    // Print all stored keys
    std::cout << "\n========================= Task 3.1: Print keys in each node =========================\n";
-   Node::printAllKeys(n0);
+   ring.printAllKeys();
 
    // Adding a new node (100)
    std::cout << "\n========================= Task 3.2: Adding Node (100), and printing migrated keys =========================\n";
-   Node* n6 = new Node(100);
+   Node* n6 = ring.addNode(100);
    n6->join(n0);
-   Node::stabilizeNetwork(n0);
-   Node::fixAllFingers(n0);
+   ring.stabilizeNetwork();
+   ring.fixAllFingers();
    
-   std::vector<uint8_t> keysToLookup = {3, 200, 123, 45, 99, 60, 50, 100, 101, 102, 240, 250};
+   std::vector<NodeId> keysToLookup = {3, 200, 123, 45, 99, 60, 50, 100, 101, 102, 240, 250};
    std::vector<Node*> lookupNodes = {n0, n2, n6};
    
    std::cout << "\n========================= Task 4: Lookup keys from specific nodes =========================\n";
    for (Node* lookupNode : lookupNodes) {
-       for (uint8_t key : keysToLookup) {
+       for (const NodeId& key : keysToLookup) {
            lookupNode->find(key);
         }
         std::cout << "--------------------------------\n";
@@ -71,13 +71,13 @@ int main() {
     // Print the ring structure and finger tables after removal
     std::cout << "\n========================= Task 5: Removing Node 65, and printing finger table =========================\n";
     n2->leave();
-    Node::stabilizeNetwork(n0);
-    Node::fixAllFingers(n0);
-    Node::printAllFingerTables(n0);
+    ring.stabilizeNetwork();
+    ring.fixAllFingers();
+    ring.printAllFingerTables();
 
     // Clean up
     std::cout << "\n========================= Cleaning Up: Deleting All Nodes =========================\n";
-    Node::deleteAllNodes(n0);
+    ring.clear();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+RingMetrics globalMetrics;
+
+uint64_t bucketHigh(int b) {
+    return b + 1 < Histogram::kBuckets ? Histogram::bucketLow(b + 1) - 1 : ~(uint64_t)0;
+}
+
+void writeHistogramJson(std::ostream& out, const Histogram& h) {
+    out << "{\"count\": " << h.count() << ", \"sum\": " << h.sum() << ", \"mean\": " << h.mean()
+        << ", \"p50\": " << h.percentile(0.5) << ", \"p90\": " << h.percentile(0.9)
+        << ", \"p99\": " << h.percentile(0.99) << ", \"max\": " << h.max() << ", \"buckets\": [";
+    bool first = true;
+    for (const auto& b : h.buckets()) {
+        out << (first ? "" : ", ") << "[" << b.first << ", " << b.second << "]";
+        first = false;
+    }
+    out << "]}";
+}
+
+void writeNodeJson(std::ostream& out, const NodeMetrics& m) {
+    out << "\"lookups\": " << m.lookups << ", \"lookup_hops\": " << m.lookupHops
+        << ", \"lookup_timeouts\": " << m.lookupTimeouts << ", \"stabilize_calls\": " << m.stabilizeCalls
+        << ", \"stabilize_messages\": " << m.stabilizeMessages << ", \"successor_changes\": " << m.successorChanges
+        << ", \"notify_calls\": " << m.notifyCalls << ", \"predecessor_changes\": " << m.predecessorChanges
+        << ", \"fix_fingers_calls\": " << m.fixFingersCalls << ", \"fingers_changed\": " << m.fingersChanged
+        << ", \"keys_migrated_in\": " << m.keysMigratedIn << ", \"keys_migrated_out\": " << m.keysMigratedOut
+        << ", \"hops_per_lookup\": ";
+    writeHistogramJson(out, m.hopsPerLookup);
+}
+
+void writeHistogramCsv(std::ostream& out, const Histogram& h) {
+    out << "," << h.count() << "," << h.mean() << "," << h.percentile(0.5) << "," << h.percentile(0.99) << ","
+        << h.max();
+}
+
+void writeNodeCsv(std::ostream& out, const NodeMetrics& m) {
+    out << "," << m.lookups << "," << m.lookupHops << "," << m.lookupTimeouts << "," << m.stabilizeCalls << ","
+        << m.stabilizeMessages << "," << m.successorChanges << "," << m.notifyCalls << "," << m.predecessorChanges
+        << "," << m.fixFingersCalls << "," << m.fingersChanged << "," << m.keysMigratedIn << ","
+        << m.keysMigratedOut;
+    writeHistogramCsv(out, m.hopsPerLookup);
+    out << "\n";
+}
+
+}  // namespace
+
+uint64_t Histogram::percentile(double p) const {
+    if (count_ == 0) return 0;
+    // Nearest rank, 1-based
+    uint64_t rank = (uint64_t)std::ceil(std::min(1.0, std::max(0.0, p)) * count_);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; b++) {
+        seen += counts_[b];
+        if (seen >= rank) return std::min(bucketHigh(b), max_);
+    }
+    return max_;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> Histogram::buckets() const {
+    std::vector<std::pair<uint64_t, uint64_t>> out;
+    for (int b = 0; b < kBuckets; b++) {
+        if (counts_[b]) out.emplace_back(bucketLow(b), counts_[b]);
+    }
+    return out;
+}
+
+void Histogram::clear() {
+    std::memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+Histogram& Histogram::operator+=(const Histogram& other) {
+    for (int b = 0; b < kBuckets; b++) counts_[b] += other.counts_[b];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+    return *this;
+}
+
+NodeMetrics& NodeMetrics::operator+=(const NodeMetrics& other) {
+    lookups += other.lookups;
+    lookupHops += other.lookupHops;
+    lookupTimeouts += other.lookupTimeouts;
+    stabilizeCalls += other.stabilizeCalls;
+    stabilizeMessages += other.stabilizeMessages;
+    successorChanges += other.successorChanges;
+    notifyCalls += other.notifyCalls;
+    predecessorChanges += other.predecessorChanges;
+    fixFingersCalls += other.fixFingersCalls;
+    fingersChanged += other.fingersChanged;
+    keysMigratedIn += other.keysMigratedIn;
+    keysMigratedOut += other.keysMigratedOut;
+    hopsPerLookup += other.hopsPerLookup;
+    return *this;
+}
+
+RingMetrics& Metrics::global() {
+    return globalMetrics;
+}
+
+void Metrics::reset() {
+    globalMetrics = RingMetrics();
+}
+
+void MetricsSnapshot::writeJson(std::ostream& out, bool perNode) const {
+    out << "{\n  \"enabled\": " << (enabled ? "true" : "false") << ",\n"
+        << "  \"ring\": {\"stabilize_rounds\": " << ring.stabilizeRounds
+        << ", \"fix_fingers_rounds\": " << ring.fixFingersRounds << ", \"migrations\": " << ring.migrations
+        << ",\n    \"messages_per_stabilize_round\": ";
+    writeHistogramJson(out, ring.messagesPerStabilizeRound);
+    out << ",\n    \"fingers_changed_per_round\": ";
+    writeHistogramJson(out, ring.fingersChangedPerRound);
+    out << ",\n    \"fingers_changed_per_fix\": ";
+    writeHistogramJson(out, ring.fingersChangedPerFix);
+    out << ",\n    \"keys_per_migration\": ";
+    writeHistogramJson(out, ring.keysPerMigration);
+    out << "},\n  \"total\": {";
+    writeNodeJson(out, total);
+    out << "}";
+    if (perNode) {
+        out << ",\n  \"nodes\": [";
+        for (size_t i = 0; i < nodes.size(); i++) {
+            out << (i ? ",\n    " : "\n    ") << "{\"id\": \"" << idToString(nodes[i].id)
+                << "\", \"in_ring\": " << (nodes[i].inRing ? "true" : "false") << ", ";
+            writeNodeJson(out, nodes[i].metrics);
+            out << "}";
+        }
+        out << (nodes.empty() ? "]" : "\n  ]");
+    }
+    out << "\n}\n";
+}
+
+void MetricsSnapshot::writeCsv(std::ostream& out) const {
+    out << "node,in_ring,lookups,lookup_hops,lookup_timeouts,stabilize_calls,stabilize_messages,"
+           "successor_changes,notify_calls,predecessor_changes,fix_fingers_calls,fingers_changed,"
+           "keys_migrated_in,keys_migrated_out,hops_count,hops_mean,hops_p50,hops_p99,hops_max\n";
+    for (const Entry& e : nodes) {
+        out << idToString(e.id) << "," << (e.inRing ? 1 : 0);
+        writeNodeCsv(out, e.metrics);
+    }
+    out << "total,";
+    writeNodeCsv(out, total);
+}
@@ -1,101 +1,166 @@
 #include "node.h"
+#include "log.h"
+#include "parallel.h"
 #include <iostream>
 #include <limits>
 #include <cmath>
+#include <algorithm>
+#include <numeric>
 
-Node::Node(uint8_t id)
+Node::Node(NodeId id, NodePool* pool, NodeHandle handle)
     : id_(id),
+      pool_(pool),
+      handle_(handle),
+      host_(handle),
+      requestsServed_(0),
+      inRing_(false),
       fingerTable_(this),
       successor_(this),
       predecessor_(nullptr),
-      nextFingerToFix_(1)
+      predecessorLost_(false),
+      nextFingerToFix_(1),
+      outgoing_(nullptr)
 {
+    std::fill(successorList_, successorList_ + SUCCESSOR_LIST_LENGTH, this);
 }
 
 // Helper: ring interval check
-bool Node::inInterval(uint8_t x, uint8_t start, uint8_t end,
+bool Node::inInterval(NodeId x, NodeId start, NodeId end,
                       bool inclusiveStart, bool inclusiveEnd) {
-    const uint16_t ringSize = (1 << BITLENGTH);
-
-    // A lambda to normalize distances in the ring
-    auto modDist = [&](uint16_t a, uint16_t b) {
-        return (a + ringSize - b) % ringSize;
-    };
-
-    if (start == end) {
-        return inclusiveStart || inclusiveEnd;
-    }
-
-    uint16_t shiftedX   = modDist(x, start);
-    uint16_t shiftedEnd = modDist(end, start);
-
-    if (x == start && inclusiveStart) return true;
-    if (x == end && inclusiveEnd) return true;
-    if (shiftedEnd == 0) return true;  // Whole ring case
-    return (shiftedX > 0 && shiftedX < shiftedEnd);
+    return ChordSpace::inInterval(x, start, end, inclusiveStart, inclusiveEnd);
 }
 
 // Return this node's ID
-uint8_t Node::getId() {
+NodeId Node::getId() {
     return id_;
 }
 
 // Join
-void Node::join(Node* knownNode) {
+void Node::join(Node* knownNode, size_t migrationChunk) {
     if (knownNode == nullptr) {
         predecessor_ = nullptr;
         successor_ = this;
-        std::cout << "Node " << (int)id_ << " created as FIRST node in Chord.\n";
+        DHT_LOG_INFO("Node " << idToString(id_) << " created as FIRST node in Chord.");
     } else {
         successor_ = knownNode->find_successor(id_);
+        if (!successor_) {
+            DHT_LOG_ERROR("Node " << idToString(id_) << " could not join via Node "
+                          << idToString(knownNode->getId()) << ": no live successor found");
+            successor_ = this;
+            return;
+        }
         predecessor_ = successor_->getPredecessor();
 
         if (!predecessor_ || predecessor_ == successor_) {
             predecessor_ = knownNode;
         }
 
+        // Streams into or out of either neighbour end first: the replica upkeep
+        // the new links trigger must see those keys in their owners' stores
+        for (Node* neighbour : {predecessor_, successor_}) {
+            neighbour->finishMigration();
+            if (neighbour->outgoing_) neighbour->outgoing_->finishMigration();
+        }
+
+        // In the ring before the links change, so the predecessor's replica upkeep counts this node
+        inRing_ = true;
         successor_->setPredecessor(this);
         predecessor_->setSuccessor(this);
 
-        std::cout << "Node " << (int)id_
-                  << " joined via Node " << (int)knownNode->getId() << "\n";
-
-        std::vector<uint8_t> keysToMigrate;
-        for (auto& kv : successor_->localKeys_) {
-            if (inInterval(kv.first, predecessor_->getId(), id_, false, true)) {
-                keysToMigrate.push_back(kv.first);
-            }
-        }
+        DHT_LOG_INFO("Node " << idToString(id_)
+                     << " joined via Node " << idToString(knownNode->getId()));
 
-        for (uint8_t key : keysToMigrate) {
-            localKeys_[key] = successor_->localKeys_[key]; // Move key-value pair
-            successor_->localKeys_.erase(key); // Remove from old node
-            std::cout << "Migrated key " << (int)key << " to Node " << (int)id_ << std::endl;
-        }
+        // Take over the keys in (predecessor, this] from the successor
+        beginMigration(successor_, predecessor_->getId(), id_, migrationChunk, false);
     }
 
+    inRing_ = true;
+    refreshSuccessorList();
     fingerTable_.initialize();
 }
 
-void Node::stabilizeAll(std::vector<Node*>& nodes) {
-    for (int i = 0; i < 5; i++) {  // Run multiple rounds for full propagation
+int Node::stabilizeAll(std::vector<Node*>& nodes) {
+    // Run rounds until one changes nothing (a fixed point), bounded by the ring size
+    const size_t maxRounds = std::max<size_t>(5, nodes.size());
+    int rounds = 0;
+    bool changed = true;
+    while (changed && (size_t)rounds < maxRounds) {
+        changed = false;
+#if DHT_METRICS
+        uint64_t messages = 0;
+        for (Node* node : nodes) {
+            uint64_t before = node->metrics_.stabilizeMessages;
+            changed |= node->stabilize();
+            messages += node->metrics_.stabilizeMessages - before;
+        }
+        Metrics::global().stabilizeRounds++;
+        Metrics::global().messagesPerStabilizeRound.record(messages);
+#else
         for (Node* node : nodes) {
-            node->stabilize();
+            changed |= node->stabilize();
         }
+#endif
+        rounds++;
     }
+    return rounds;
 }
 
-void Node::fixAllFingers(Node* startNode) {
+int Node::fixAllFingers(Node* startNode) {
     // Collect all nodes dynamically
     std::vector<Node*> allNodes = startNode->collectAllNodes();
+    return fixAllFingers(allNodes);
+}
 
-    // Run fix_fingers on each node multiple times
+int Node::fixAllFingers(std::vector<Node*>& allNodes) {
+    // Run fix_fingers on each node until a full round leaves every table unchanged
     //std::cout << "\n=== Fixing Finger Tables for All Nodes ===\n";
-    for (int i = 0; i < 5; i++) {  // Run multiple times for full updates
+    const size_t maxRounds = std::max<size_t>(5, allNodes.size());
+    int totalChanged = 0;
+    for (size_t round = 0; round < maxRounds; round++) {
+        int changed = 0;
         for (Node* node : allNodes) {
-            node->fix_fingers();
+            changed += node->fix_fingers();
+        }
+        totalChanged += changed;
+        DHT_METRIC(Metrics::global().fixFingersRounds++, Metrics::global().fingersChangedPerRound.record(changed));
+        if (changed == 0) break;
+    }
+    return totalChanged;
+}
+
+int Node::repairFingersAfterJoin() {
+    if (!predecessor_ || successor_ == this) return 0;
+    return repairFingerArc(predecessor_->getId(), id_, this);
+}
+
+int Node::repairFingersAfterLeave() {
+    if (!predecessor_ || successor_ == this) return 0;
+    // Route through the successor: this node is no longer part of the ring
+    return successor_->repairFingerArc(predecessor_->getId(), id_, successor_);
+}
+
+int Node::repairFingerArc(NodeId arcStart, NodeId arcEnd, Node* owner) {
+    int changed = 0;
+    for (int i = 1; i <= BITLENGTH; i++) {
+        // Nodes x with x + 2^(i-1) in (arcStart, arcEnd]
+        NodeId offset = ChordSpace::pow2(i - 1);
+        NodeId lo = ChordSpace::sub(arcStart, offset);
+        NodeId hi = ChordSpace::sub(arcEnd, offset);
+
+        Node* x = lookup(ChordSpace::add(lo, NodeId(1))).node;
+        if (!x) continue;  // Whole successor list failed; stabilize will catch up
+        Node* first = x;
+        while (inInterval(x->getId(), lo, hi, false, true)) {
+            if (x != owner && x->fingerTable_.get(i) != owner) {
+                x->fingerTable_.set(i, owner);
+                DHT_METRIC(x->metrics_.fingersChanged++);
+                changed++;
+            }
+            x = x->successor_;
+            if (x == first) break;  // Arc covers the whole ring
         }
     }
+    return changed;
 }
 
 void Node::printAllKeys(Node* startNode) {
@@ -127,10 +192,10 @@ void Node::printRing(Node* startNode) {
 
     Node* current = startNode;
     do {
-        std::cout << "Node " << (int)current->getId() 
-                  << " -> Successor: " << (int)current->getSuccessor()->getId() 
+        std::cout << "Node " << idToString(current->getId()) 
+                  << " -> Successor: " << idToString(current->getSuccessor()->getId()) 
                   << " | Predecessor: " 
-                  << (current->getPredecessor() ? std::to_string(current->getPredecessor()->getId()) : "None") 
+                  << (current->getPredecessor() ? idToString(current->getPredecessor()->getId()) : "None") 
                   << std::endl;
         current = current->getSuccessor();
     } while (current != startNode);  // Stop when we've completed a full cycle
@@ -138,31 +203,23 @@ void Node::printRing(Node* startNode) {
     std::cout << "============================\n";
 }
 
-void Node::find(uint8_t key) {
-    std::cout << "\n Look-up result of key " << (int)key
-              << " from Node " << (int)this->getId() << ":\n";
-
-    Node* responsibleNode = this->find_successor(key);
-    int value = -1;
-
-    if (responsibleNode->localKeys_.count(key)) {
-        value = responsibleNode->localKeys_[key];
+void Node::find(NodeId key) {
+    LookupResult result = cachedLookup(key, false, REPLICATION_FACTOR > 1);
+    Node* responsibleNode = result.node;
+    if (!responsibleNode) {
+        DHT_LOG_WARN("\n Look-up of key " << idToString(key) << " from Node " << idToString(id_)
+                     << " failed: no live successor");
+        return;
     }
+    const Value* stored = storedValue(result, key);
 
-    std::cout << " Found at Node " << (int)responsibleNode->getId() << "\n"
-              << " Key " << (int)key << " -> Value: "
-              << (value == -1 ? "None" : std::to_string(value)) << "\n";
-}
-
-void Node::deleteAllNodes(Node* startNode) {
-    // Collect all nodes dynamically
-    std::vector<Node*> allNodes = startNode->collectAllNodes();
-
-    // Delete all nodes
-    //std::cout << "\n=== Cleaning Up: Deleting All Nodes ===\n";
-    for (Node* node : allNodes) {
-        delete node;
-    }
+    DHT_LOG_INFO("\n Look-up result of key " << idToString(key)
+                 << " from Node " << idToString(this->getId()) << ":\n"
+                 << " Found at Node " << idToString(responsibleNode->getId())
+                 << (result.replica ? " (replica)" : "") << "\n"
+                 << " Key " << idToString(key) << " -> Value: "
+                 << (stored ? valueToString(*stored) : "None"));
+    (void)stored;  // Only reported through the log
 }
 
 std::vector<Node*> Node::collectAllNodes() {
@@ -186,21 +243,21 @@ void Node::stabilizeNetwork(Node* startNode) {
     Node::stabilizeAll(allNodes);
 }
 
-void Node::leave() {
-    std::cout << "Node " << (int)id_ << " is leaving the ring.\n";
+void Node::leave(size_t migrationChunk) {
+    DHT_LOG_INFO("Node " << idToString(id_) << " is leaving the ring.");
+    inRing_ = false;
+    if (locationCache_) locationCache_->clear();
 
     if (successor_ == this && predecessor_ == nullptr) {
         // Only one node in the ring, it can simply leave.
-        std::cout << "Last node in the ring. Removing it.\n";
+        DHT_LOG_INFO("Last node in the ring. Removing it.");
         return;
     }
 
     if (successor_ != this) {
-        for (auto& kv : localKeys_) {
-            successor_->localKeys_[kv.first] = kv.second;
-            std::cout << "Transferred key " << (int)kv.first << " to Node " << (int)successor_->getId() << "\n";
-        }
-        localKeys_.clear();  // Empty key storage from this node
+        // Hand the whole store to the successor; (id, id] selects every key
+        successor_->beginMigration(this, id_, id_, migrationChunk, true);
+        replicaKeys_.clear();
     }
 
     if (predecessor_) {
@@ -210,67 +267,786 @@ void Node::leave() {
         successor_->setPredecessor(predecessor_);
     }
 
-    std::cout << "Node " << (int)id_ << " has left the ring.\n";
+    DHT_LOG_INFO("Node " << idToString(id_) << " has left the ring.");
+}
+
+void Node::fail() {
+    DHT_LOG_INFO("Node " << idToString(id_) << " failed.");
+    inRing_ = false;
+    if (locationCache_) locationCache_->clear();
+    // Keys still streaming out are lost with the rest of the store; the receiver falls back on their replicas
+    if (outgoing_) outgoing_->recoverStaged();
+    // Keys not sent yet never left the source
+    if (incoming_.from) {
+        returnStaged();
+        endMigration();
+    }
+}
+
+size_t Node::continueMigration() {
+    if (!incoming_.from) return 0;
+    Migration& m = incoming_;
+    Node* shiftedHolder = m.handOver ? lastReplicaTarget() : m.from->lastReplicaTarget();
+    size_t last = m.next + std::min(m.chunk, m.staged.size() - m.next);
+
+    // Pack the chunk's live keys to its front, then add them in one run
+    size_t kept = m.next;
+    for (size_t i = m.next; i < last; i++) {
+        if (m.dropped[i]) continue;
+        m.from->handOffKey(this, m.staged[i].first, m.staged[i].second, m.handOver, shiftedHolder);
+        if (kept != i) m.staged[kept] = std::move(m.staged[i]);
+        kept++;
+    }
+    localKeys_.insertRun(m.staged.begin() + m.next, m.staged.begin() + kept);
+    size_t moved = kept - m.next;
+    DHT_METRIC(recordMigration(m.from, moved));
+
+    m.next = last;
+    if (m.next == m.staged.size()) endMigration();
+    return moved;
+}
+
+void Node::finishMigration() {
+    if (!incoming_.from) return;
+    incoming_.chunk = (size_t)-1;
+    continueMigration();
+}
+
+void Node::endMigration() {
+    incoming_.from->outgoing_ = nullptr;
+    incoming_ = Migration();
+}
+
+void Node::returnStaged() {
+    Migration& m = incoming_;
+    size_t kept = m.next;
+    for (size_t i = m.next; i < m.staged.size(); i++) {
+        if (m.dropped[i]) continue;
+        if (kept != i) m.staged[kept] = std::move(m.staged[i]);
+        kept++;
+    }
+    m.from->localKeys_.insertRun(m.staged.begin() + m.next, m.staged.begin() + kept);
+    m.next = m.staged.size();
+}
+
+size_t Node::recoverStaged() {
+    Migration& m = incoming_;
+    // A leaving source handed over its whole store; its own keys end at its id
+    NodeId a = m.handOver && predecessor_ ? predecessor_->id_ : m.start;
+    NodeId b = m.handOver ? m.from->id_ : m.end;
+    bool known = !m.handOver || predecessor_;
+    endMigration();
+    if (REPLICATION_FACTOR == 1 || !known) return 0;
+
+    // The source's replica holders are this node's live successors (and this node, on a leave)
+    Node* holders[SUCCESSOR_LIST_LENGTH + 1];
+    int count = 0;
+    holders[count++] = this;
+    for (Node* s : successorList_) {
+        if (s == this || !s->inRing_ || std::find(holders, holders + count, s) != holders + count) continue;
+        holders[count++] = s;
+    }
+    std::vector<NodeId> recovered;
+    for (int i = 0; i < count; i++) {
+        holders[i]->replicaKeys_.forEachInInterval(a, b, [&](const NodeId& key, const Value& value) {
+            if (localKeys_.find(key)) return true;
+            DHT_LOG_INFO("Node " << idToString(id_) << " took over key " << idToString(key) << " from a replica");
+            localKeys_.put(key, cloneValue(value));
+            recovered.push_back(key);
+            return true;
+        });
+    }
+    for (const NodeId& key : recovered) {
+        replicaKeys_.erase(key);
+        replicate(key, *localKeys_.find(key));
+    }
+    if (!recovered.empty()) DHT_METRIC(recordMigration(nullptr, recovered.size()));
+    return recovered.size();
+}
+
+void Node::forEachStaged(const std::function<void(const NodeId&, const Value&)>& visit) const {
+    for (size_t i = incoming_.next; i < incoming_.staged.size(); i++) {
+        if (!incoming_.dropped[i]) visit(incoming_.staged[i].first, incoming_.staged[i].second);
+    }
+}
+
+bool Node::forEachStoredInInterval(const NodeId& a, const NodeId& b,
+                                   const std::function<bool(const NodeId&, const Value&)>& visit) const {
+    const Migration& m = incoming_;
+    using Entry = KeyStore<Value>::Entry;
+    std::vector<const Entry*> staged;
+    for (size_t i = m.next; i < m.staged.size(); i++) {
+        if (m.dropped[i] || !ChordSpace::inInterval(m.staged[i].first, a, b, false, true)) continue;
+        staged.push_back(&m.staged[i]);
+    }
+    if (staged.empty()) return localKeys_.forEachInInterval(a, b, visit);
+
+    // Staged keys are in ring order from the migration's start, which need not be a
+    const NodeId afterA = ChordSpace::add(a, NodeId(1));
+    auto rank = [&](const NodeId& key) { return ChordSpace::distance(afterA, key); };
+    std::sort(staged.begin(), staged.end(),
+              [&](const Entry* x, const Entry* y) { return rank(x->first) < rank(y->first); });
+    size_t next = 0;
+    bool more = localKeys_.forEachInInterval(a, b, [&](const NodeId& key, const Value& value) {
+        for (; next < staged.size() && rank(staged[next]->first) <= rank(key); next++) {
+            if (staged[next]->first != key && !visit(staged[next]->first, staged[next]->second)) return false;
+        }
+        return visit(key, value);
+    });
+    for (; more && next < staged.size(); next++) more = visit(staged[next]->first, staged[next]->second);
+    return more;
+}
+
+void Node::forEachReplicated(const std::function<void(const NodeId&, const Value&)>& visit) const {
+    localKeys_.forEach(visit);
+    // Staged keys stay with the node that keeps stabilizing: the source of a
+    // join until they arrive, or the receiver once the source has left
+    if (outgoing_ && !outgoing_->incoming_.handOver) outgoing_->forEachStaged(visit);
+    if (incoming_.from && incoming_.handOver) forEachStaged(visit);
+}
+
+void Node::beginMigration(Node* from, const NodeId& a, const NodeId& b, size_t chunk, bool handOver) {
+    // One migration per node at a time, and the source must hold all its keys
+    finishMigration();
+    from->finishMigration();
+    if (from->outgoing_) from->outgoing_->finishMigration();
+
+    if (chunk == 0) {
+        from->moveKeys(this, a, b, handOver);
+        return;
+    }
+    // One pass over the source's store now; every step after that works on the staged keys only
+    from->localKeys_.extractInterval(a, b, incoming_.staged);
+    if (incoming_.staged.empty()) return;
+    incoming_.dropped.assign(incoming_.staged.size(), 0);
+    incoming_.from = from;
+    incoming_.start = a;
+    incoming_.end = b;
+    incoming_.chunk = chunk;
+    incoming_.handOver = handOver;
+    from->outgoing_ = this;
+}
+
+size_t Node::moveKeys(Node* to, const NodeId& a, const NodeId& b, bool handOver) {
+#if DHT_LOG_LEVEL >= DHT_LOG_LEVEL_INFO || REPLICATION_FACTOR > 1
+    // Per-key work only for logging and replicas; the move itself is one splice
+    Node* shiftedHolder = handOver ? to->lastReplicaTarget() : lastReplicaTarget();
+    localKeys_.forEachInInterval(a, b, [&](const NodeId& key, const Value& value) {
+        handOffKey(to, key, value, handOver, shiftedHolder);
+        return true;
+    });
+#else
+    (void)handOver;
+#endif
+    size_t moved = localKeys_.moveInterval(a, b, to->localKeys_);
+    DHT_METRIC(to->recordMigration(this, moved));
+    return moved;
+}
+
+void Node::handOffKey(Node* to, const NodeId& key, const Value& value, bool handOver, Node* shiftedHolder) {
+    // A join pushes every holder one place along: this node becomes the first
+    // and shiftedHolder, the last, drops out. A leave pulls them one place back:
+    // `to` stops holding a replica and shiftedHolder, after its last target, starts
+    if (REPLICATION_FACTOR > 1) {
+        if (handOver) {
+            to->replicaKeys_.erase(key);
+            if (shiftedHolder) shiftedHolder->replicaKeys_.put(key, cloneValue(value));
+        } else {
+            if (!to->localKeys_.find(key)) replicaKeys_.put(key, cloneValue(value));
+            if (shiftedHolder) shiftedHolder->replicaKeys_.erase(key);
+        }
+    }
+    if (handOver) {
+        DHT_LOG_INFO("Transferred key " << idToString(key) << " to Node " << idToString(to->id_));
+    } else {
+        DHT_LOG_INFO("Migrated key " << idToString(key) << " to Node " << idToString(to->id_));
+    }
+    (void)value;
+    (void)shiftedHolder;
+}
+
+Node* Node::lastReplicaTarget() {
+    Node* targets[REPLICATION_FACTOR] = {};
+    int count = REPLICATION_FACTOR > 1 ? replicaTargets(targets) : 0;
+    return count > 0 && count == REPLICATION_FACTOR - 1 ? targets[count - 1] : nullptr;
+}
+
+ptrdiff_t Node::stagedIndex(const NodeId& key) const {
+    const Migration& m = incoming_;
+    if (!m.from || !ChordSpace::inInterval(key, m.start, m.end, false, true)) return -1;
+    // Staged keys are sorted by their distance from start + 1 (start itself last)
+    const NodeId afterStart = ChordSpace::add(m.start, NodeId(1));
+    const NodeId d = ChordSpace::distance(afterStart, key);
+    auto it = std::lower_bound(m.staged.begin() + m.next, m.staged.end(), d,
+                               [&](const KeyStore<Value>::Entry& e, const NodeId& x) {
+                                   return ChordSpace::distance(afterStart, e.first) < x;
+                               });
+    if (it == m.staged.end() || it->first != key) return -1;
+    ptrdiff_t i = it - m.staged.begin();
+    return m.dropped[i] ? -1 : i;
+}
+
+Value* Node::findInTransit(const NodeId& key) {
+    ptrdiff_t i = stagedIndex(key);
+    return i < 0 ? nullptr : &incoming_.staged[i].second;
+}
+
+void Node::dropInTransit(const NodeId& key) {
+    ptrdiff_t i = stagedIndex(key);
+    if (i < 0) return;
+    // The source's replicas go too: the chunk that would have dropped them never carries this key
+    incoming_.dropped[i] = 1;
+    incoming_.staged[i].second = Value();
+    if (REPLICATION_FACTOR > 1) incoming_.from->dropReplicas(key);
+}
+
+const Value* Node::storedValue(const LookupResult& result, const NodeId& key) {
+    Node* holder = result.node;
+    const Value* value = result.replica ? holder->replicaKeys_.find(key) : holder->localKeys_.find(key);
+    if (value) return value;
+    if (!result.replica) return holder->findInTransit(key);
+    // The holder's predecessor may still be pulling the key out of the holder
+    return holder->predecessor_ ? holder->predecessor_->findInTransit(key) : nullptr;
 }
 
 // Find successor
-Node* Node::find_successor(uint8_t key) {
-    // If the key is exactly this node's ID, we are responsible.
-    if (key == id_) {
-        return this;
+Node* Node::find_successor(NodeId key) {
+    return lookup(key).node;
+}
+
+// Iterative lookup: each loop iteration is one forwarding hop
+LookupResult Node::lookup(NodeId key, bool recordPath, bool readReplica) {
+    LookupResult result;
+    Node* current = this;
+    if (recordPath) result.path.push_back(current);
+
+    while (true) {
+        // If the key is exactly the current node's ID, it is responsible.
+        if (key == current->id_) {
+            result.node = current;
+            break;
+        }
+
+        // A failed successor is replaced by the first live successor list entry
+        Node* successor = current->liveSuccessor();
+        if (!successor) {
+            result.node = nullptr;  // Every known successor failed
+            break;
+        }
+        if (successor != current->successor_) result.timeouts++;
+
+        // Key within the successor list -> any copy there can answer
+        if (readReplica && REPLICATION_FACTOR > 1) {
+            Node* holder = current->replicaHolder(key, handle_, result.replica);
+            if (holder) {
+                result.node = holder;
+                break;
+            }
+        }
+
+        // Key in (current, successor] -> the successor is responsible.
+        if (inInterval(key, current->id_, successor->id_, false, true)) {
+            result.node = successor;
+            break;
+        }
+
+        // No finger precedes the key (e.g. stale fingers after a join):
+        // the key is not in (current, successor], so walk to the successor.
+        Node* next = current->closest_preceding_live(key, result.timeouts);
+        if (next == current) {
+            next = successor;
+        }
+
+        current = next;
+        result.hops++;
+        if (recordPath) result.path.push_back(current);
+    }
+
+    if (recordPath && result.node && result.path.back() != result.node) {
+        result.path.push_back(result.node);
+    }
+    DHT_METRIC(recordLookup(result));
+    return result;
+}
+
+// Batched lookup: keys taking the same next hop travel as one group
+std::vector<LookupResult> Node::lookupBatch(const std::vector<NodeId>& keys) {
+    std::vector<LookupResult> results(keys.size());
+
+    // Sort once by clockwise distance from this node. Forwarding to a finger
+    // that precedes every key of a group keeps the group in ring order.
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return ChordSpace::distance(id_, keys[a]) < ChordSpace::distance(id_, keys[b]);
+    });
+
+    struct Group {
+        Node* node;     // Node currently holding the group
+        int hops;       // Hops taken so far by every key in the group
+        size_t begin;   // Range [begin, end) of `order`
+        size_t end;
+    };
+    std::vector<Group> pending;
+    if (!order.empty()) pending.push_back({this, 0, 0, order.size()});
+
+    while (!pending.empty()) {
+        Group group = pending.back();
+        pending.pop_back();
+        Node* current = group.node;
+        Node* successor = current->liveSuccessor();  // nullptr if every known successor failed
+
+        Node* runNext = nullptr;        // Next hop of the run being built
+        size_t runBegin = group.begin;
+
+        auto flushRun = [&](size_t runEnd) {
+            if (runNext && runBegin < runEnd) {
+                pending.push_back({runNext, group.hops + 1, runBegin, runEnd});
+            }
+            runNext = nullptr;
+        };
+
+        for (size_t k = group.begin; k < group.end; ++k) {
+            size_t idx = order[k];
+            const NodeId& key = keys[idx];
+
+            bool resolved = true;
+            Node* responsible = nullptr;
+            Node* next = nullptr;
+            if (key == current->id_) {
+                responsible = current;
+            } else if (!successor) {
+                // Unresolvable: responsible stays nullptr
+            } else if (inInterval(key, current->id_, successor->getId(), false, true)) {
+                responsible = successor;
+            } else {
+                int timeouts = 0;
+                next = current->closest_preceding_live(key, timeouts);
+                if (next == current) {
+                    next = successor;
+                }
+                resolved = false;
+            }
+
+            if (resolved) {
+                results[idx].node = responsible;
+                results[idx].hops = group.hops;
+                flushRun(k);
+                runBegin = k + 1;
+            } else if (next != runNext) {
+                flushRun(k);
+                runNext = next;
+                runBegin = k;
+            }
+        }
+        flushRun(group.end);
     }
 
-    // Otherwise check if key is in (id_, successor->id].
-    if (inInterval(key, id_, successor_->getId(), false, true)) {
-        return successor_;
+#if DHT_METRICS
+    for (const LookupResult& result : results) recordLookup(result);
+#endif
+    return results;
+}
+
+LookupResult Node::cachedLookup(NodeId key, bool recordPath, bool readReplica) {
+    if (!locationCache_) {
+        LookupResult result = lookup(key, recordPath, readReplica);
+        if (result.node) result.node->requestsServed_++;
+        return result;
+    }
+    LocationCache& cache = *locationCache_;
+
+    int cachedHops = 0;
+    Node* cached = cache.find(key, cachedHops);
+    if (cached) {
+        // Ask the cached owner directly: one hop, or none for our own range
+        if (cached->ownsKey(key)) {
+            LookupResult result;
+            result.node = cached;
+            result.hops = cached == this ? 0 : 1;
+            if (recordPath) {
+                result.path.push_back(this);
+                if (cached != this) result.path.push_back(cached);
+            }
+            cache.stats.hits++;
+            cache.stats.hopsSaved += (uint64_t)std::max(0, cachedHops - result.hops);
+            cached->requestsServed_++;
+            return result;
+        }
+        cache.stats.stale++;
+        cache.erase(key);
+    } else {
+        cache.stats.misses++;
+    }
+
+    LookupResult result = lookup(key, recordPath, readReplica);
+    if (cached) result.hops++;  // The wasted probe
+    Node* owner = result.node;
+    if (owner && !result.replica && owner->predecessor_) {
+        cache.insert(owner->predecessor_->id_, owner->id_, owner, result.hops);
+    }
+    if (owner) owner->requestsServed_++;
+    return result;
+}
+
+void Node::enableLocationCache(size_t capacity) {
+    if (capacity == 0) {
+        locationCache_.reset();
     } else {
-        Node* node = closest_preceding_finger(key);
-        // If node == this, we can just return successor_, or handle it carefully:
-        return (node == this) ? successor_ : node->find_successor(key);
+        locationCache_.reset(new LocationCache(capacity));
     }
 }
 
+bool Node::ownsKey(NodeId key) {
+    return inRing_ && predecessor_ && inInterval(key, predecessor_->id_, id_, false, true);
+}
+
 void Node::setSuccessor(Node* node) {
+    Node* oldTargets[REPLICATION_FACTOR] = {};
+    int oldTargetCount = REPLICATION_FACTOR > 1 ? replicaTargets(oldTargets) : 0;
+
+    Node** list = successorList_;
+    Node** end = list + SUCCESSOR_LIST_LENGTH;
+    Node** found = std::find(list, end, node);
+    if (found != end) {
+        // The entries before it left: shift the rest up (stabilize() refills the tail)
+        Node** tail = std::copy(found, end, list);
+        std::fill(tail, end, end[-1]);
+    } else {
+        // A node joined in front of the old successor
+        std::copy_backward(list, end - 1, end);
+        list[0] = node;
+    }
     successor_ = node;
+
+    // The replica holders move with the list: copies go to newcomers, and leave whoever dropped out
+    Node* targets[REPLICATION_FACTOR] = {};
+    int targetCount = REPLICATION_FACTOR > 1 ? replicaTargets(targets) : 0;
+    if (targetCount != oldTargetCount || !std::equal(targets, targets + targetCount, oldTargets)) {
+        dropStaleReplicas(oldTargets, oldTargetCount);
+        repairReplicas();
+    }
 }
 
 void Node::setPredecessor(Node* node) {
     predecessor_ = node;
 }
 
+#if DHT_METRICS
+void Node::recordMigration(Node* from, size_t keys) {
+    metrics_.keysMigratedIn += keys;
+    if (from) from->metrics_.keysMigratedOut += keys;
+    Metrics::global().migrations++;
+    Metrics::global().keysPerMigration.record(keys);
+}
+#endif
+
 
 // Find the closest preceding finger for a given key
-Node* Node::closest_preceding_finger(uint8_t key) {
-    for (int i = BITLENGTH; i >= 1; i--) {
-        Node* f = fingerTable_.get(i);
-        if (f && f != this && inInterval(f->getId(), id_, key, false, false)) {
-            return f;
+Node* Node::closest_preceding_finger(NodeId key) {
+    int i = fingerTable_.closestPreceding(id_, key);
+    return i ? fingerTable_.get(i) : this;
+}
+
+Node* Node::closest_preceding_live(NodeId key, int& timeouts) {
+    int i = fingerTable_.closestPreceding(id_, key);
+    Node* best = i ? fingerTable_.get(i) : this;
+    if (best == this || best->inRing_) return best;
+
+    // The chosen finger failed: take the next lower live finger that still precedes the key
+    timeouts++;
+    best = this;
+    for (int j = i - 1; j >= 1; j--) {
+        Node* finger = fingerTable_.get(j);
+        if (finger != this && inInterval(finger->id_, id_, key, false, false)) {
+            if (finger->inRing_) {
+                best = finger;
+                break;
+            }
+            timeouts++;
+        }
+    }
+
+    // A live successor list entry may get closer still
+    for (Node* s : successorList_) {
+        if (s != this && s->inRing_ && inInterval(s->id_, best->id_, key, false, false)) {
+            best = s;
+        }
+    }
+    return best;
+}
+
+Node* Node::liveSuccessor() {
+    if (successor_->inRing_ || successor_ == this) return successor_;
+    for (Node* s : successorList_) {
+        if (s->inRing_) return s;
+    }
+    return nullptr;
+}
+
+Node* Node::replicaHolder(NodeId key, NodeHandle origin, bool& replica) {
+    // The owner is the first live list entry at or past the key; the copies follow it
+    Node* holders[REPLICATION_FACTOR] = {};
+    int count = 0;
+    NodeId prev = id_;
+    for (Node* s : successorList_) {
+        if (s == this || count == REPLICATION_FACTOR) break;
+        // Until stabilize() runs after a join the list may repeat a node; (x, x] would be the whole ring
+        if (!s->inRing_ || s->id_ == prev) continue;
+        if (count == 0 && !inInterval(key, prev, s->id_, false, true)) {
+            prev = s->id_;
+            continue;
+        }
+        holders[count++] = s;
+        prev = s->id_;
+    }
+    replica = false;
+    if (count == 0) return nullptr;
+
+    // Each origin starts at its own copy, so a hot key's readers spread out
+    size_t start = (size_t)(mixId(hashId(key) ^ origin) % (uint64_t)count);
+    for (int t = 0; t < count; t++) {
+        Node* h = holders[(start + t) % count];
+        if (h->localKeys_.find(key)) {
+            replica = false;
+            return h;
         }
+        if (h->replicaKeys_.find(key)) {
+            replica = true;
+            return h;
+        }
+    }
+    return nullptr;   // No copy here: keep routing to the owner
+}
+
+int Node::replicaTargets(Node** out) {
+    int count = 0;
+    for (Node* s : successorList_) {
+        if (s == this || count == REPLICATION_FACTOR - 1) break;
+        if (!s->inRing_ || std::find(out, out + count, s) != out + count) continue;
+        out[count++] = s;
     }
-    return this;
+    return count;
+}
+
+int Node::replicate(const NodeId& key, const Value& value) {
+    Node* targets[REPLICATION_FACTOR] = {};
+    int count = replicaTargets(targets);
+    for (int i = 0; i < count; i++) targets[i]->replicaKeys_.put(key, cloneValue(value));
+    return count;
+}
+
+void Node::dropReplicas(const NodeId& key) {
+    Node* targets[REPLICATION_FACTOR] = {};
+    int count = replicaTargets(targets);
+    for (int i = 0; i < count; i++) targets[i]->replicaKeys_.erase(key);
+}
+
+void Node::dropStaleReplicas(Node* const* before, int count) {
+    Node* targets[REPLICATION_FACTOR] = {};
+    int now = replicaTargets(targets);
+    for (int i = 0; i < count; i++) {
+        Node* old = before[i];
+        if (old == this || std::find(targets, targets + now, old) != targets + now) continue;
+        forEachReplicated([&](const NodeId& key, const Value&) { old->replicaKeys_.erase(key); });
+    }
+}
+
+int Node::repairReplicas() {
+    if (REPLICATION_FACTOR == 1) return 0;
+    int written = 0;
+    forEachReplicated([&](const NodeId& key, const Value& value) { written += replicate(key, value); });
+    return written;
+}
+
+size_t Node::promoteReplicas() {
+    if (REPLICATION_FACTOR == 1 || !predecessor_ || replicaKeys_.empty()) return 0;
+    std::vector<KeyStore<Value>::Entry> promoted;
+    replicaKeys_.extractInterval(predecessor_->id_, id_, promoted);
+    size_t moved = 0;
+    for (auto& kv : promoted) {
+        if (localKeys_.find(kv.first)) continue;
+        DHT_LOG_INFO("Node " << idToString(id_) << " took over key " << idToString(kv.first) << " from a replica");
+        localKeys_.put(kv.first, std::move(kv.second));
+        moved++;
+    }
+    if (moved) DHT_METRIC(recordMigration(nullptr, moved));
+    return promoted.size();
+}
+
+bool Node::refreshSuccessorList() {
+    bool changed = successorList_[0] != successor_;
+    successorList_[0] = successor_;
+    for (int k = 1; k < SUCCESSOR_LIST_LENGTH; k++) {
+        Node* next = successor_->successorList_[k - 1];
+        changed |= successorList_[k] != next;
+        successorList_[k] = next;
+    }
+    return changed;
 }
 
 // Insert a key
 // Overloaded insert() - Default to "None" when value is not provided
-void Node::insert(uint8_t key) {
-    insert(key, -1);  // Call the other insert with a default "None" value
+void Node::insert(NodeId key) {
+    insert(key, Value());  // Call the main insert with an empty ("None") value
+}
+
+// Integer values are kept as their decimal text
+void Node::insert(NodeId key, int value) {
+    insert(key, Value(Blob(std::to_string(value))));
 }
 
 // Main insert function - Stores key-value pairs
-void Node::insert(uint8_t key, int value) {
-    Node* responsible = find_successor(key);
-    
-    // Store key with either an actual value or mark it as None (-1)
-    responsible->localKeys_[key] = value;
+void Node::insert(NodeId key, Value value) {
+    Node* responsible = cachedLookup(key).node;
+    if (!responsible) {
+        DHT_LOG_WARN("Key " << idToString(key) << " not stored: no live node responsible was found");
+        return;
+    }
+
+    DHT_LOG_INFO("Key " << idToString(key) << " stored at Node " << idToString(responsible->getId())
+                 << " with value " << valueToString(value));
+
+    // The value's buffer is handed to the responsible node, not copied
+    responsible->dropInTransit(key);
+    responsible->localKeys_.put(key, std::move(value));
+    if (REPLICATION_FACTOR > 1) responsible->replicate(key, *responsible->localKeys_.find(key));
+}
+
+// String keys are hashed onto the ring first
+void Node::insert(const std::string& key, Value value, KeyHash hash) {
+    insert(hashKey(key, hash), std::move(value));
+}
+
+// Batched insert - keys are resolved together, then stored one by one
+void Node::insertBatch(std::vector<std::pair<NodeId, Value>> items) {
+    std::vector<NodeId> keys;
+    keys.reserve(items.size());
+    for (const auto& item : items) {
+        keys.push_back(item.first);
+    }
+
+    std::vector<LookupResult> results = lookupBatch(keys);
+    for (size_t i = 0; i < items.size(); ++i) {
+        Node* responsible = results[i].node;
+        if (!responsible) {
+            DHT_LOG_WARN("Key " << idToString(items[i].first) << " not stored: no live node responsible was found");
+            continue;
+        }
+        DHT_LOG_INFO("Key " << idToString(items[i].first) << " stored at Node " << idToString(responsible->getId())
+                     << " with value " << valueToString(items[i].second));
+        responsible->requestsServed_++;
+        responsible->dropInTransit(items[i].first);
+        responsible->localKeys_.put(items[i].first, std::move(items[i].second));
+        if (REPLICATION_FACTOR > 1) responsible->replicate(items[i].first, *responsible->localKeys_.find(items[i].first));
+    }
+}
 
-    std::cout << "Key " << (int)key << " stored at Node " << (int)responsible->getId()
-              << " with value " << (value == -1 ? "None" : std::to_string(value)) << std::endl;
+// Look up a stored value
+const Value* Node::get(NodeId key) {
+    LookupResult result = cachedLookup(key, false, REPLICATION_FACTOR > 1);
+    if (!result.node) return nullptr;
+    return storedValue(result, key);
+}
+
+const Value* Node::get(const std::string& key, KeyHash hash) {
+    return get(hashKey(key, hash));
+}
+
+RangeScanStats Node::walkRange(NodeId a, NodeId b,
+                               const std::function<bool(Node*, const NodeId&, const NodeId&)>& segment) {
+    RangeScanStats stats;
+    LookupResult located = lookup(a);
+    stats.hops = located.hops;
+    Node* first = located.node;
+
+    // [a, b] == (a - 1, b]; each node holds the part of it up to its own id
+    NodeId start = ChordSpace::sub(a, NodeId(1));
+    bool wrapped = false;   // A range that ends just before a comes back to `first`
+    for (Node* n = first; n; ) {
+        bool last = inInterval(b, start, n->id_, false, true);
+        stats.nodes++;
+        if (!segment(n, start, last ? b : n->id_)) break;
+        if (last) return stats;
+        start = n->id_;
+        n = n->liveSuccessor();
+        if (n == first) {
+            if (wrapped) break;  // Around twice: the ring is inconsistent
+            wrapped = true;
+        }
+    }
+    stats.complete = false;
+    return stats;
+}
+
+RangeScanStats Node::scan(NodeId a, NodeId b,
+                          const std::function<bool(const NodeId&, const Value&)>& visit) {
+    size_t keys = 0;
+    bool stopped = false;
+    RangeScanStats stats = walkRange(a, b, [&](Node* n, const NodeId& start, const NodeId& end) {
+        n->forEachStoredInInterval(start, end, [&](const NodeId& key, const Value& value) {
+            keys++;
+            stopped = !visit(key, value);
+            return !stopped;
+        });
+        return !stopped;
+    });
+    stats.keys = keys;
+    return stats;
+}
+
+std::vector<std::pair<NodeId, Value>> Node::rangeQuery(NodeId a, NodeId b, ScanMode mode, unsigned threads,
+                                                       RangeScanStats* stats) {
+    std::vector<std::pair<NodeId, Value>> out;
+    RangeScanStats result;
+    if (mode == ScanMode::Walk) {
+        result = scan(a, b, [&](const NodeId& key, const Value& value) {
+            out.emplace_back(key, cloneValue(value));
+            return true;
+        });
+    } else {
+        struct Segment {
+            Node* node;
+            NodeId start;
+            NodeId end;
+        };
+        std::vector<Segment> segments;
+        result = walkRange(a, b, [&](Node* n, const NodeId& start, const NodeId& end) {
+            segments.push_back({n, start, end});
+            return true;
+        });
+
+        // Scanning only reads the stores, so the segments need no locking
+        std::vector<std::vector<std::pair<NodeId, Value>>> parts(segments.size());
+        parallelFor(segments.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Segment& seg = segments[i];
+                seg.node->forEachStoredInInterval(seg.start, seg.end, [&](const NodeId& key, const Value& value) {
+                    parts[i].emplace_back(key, cloneValue(value));
+                    return true;
+                });
+            }
+        });
+
+        size_t total = 0;
+        for (const auto& part : parts) total += part.size();
+        out.reserve(total);
+        for (auto& part : parts) {
+            for (auto& item : part) out.push_back(std::move(item));
+        }
+        result.keys = out.size();
+    }
+    if (stats) *stats = result;
+    return out;
 }
 
 // Remove a key
-void Node::removeKey(uint8_t key) {
-    Node* responsible = find_successor(key);
+void Node::removeKey(NodeId key) {
+    Node* responsible = cachedLookup(key).node;
+    if (!responsible) return;
     responsible->localKeys_.erase(key);
+    responsible->dropInTransit(key);
+    if (REPLICATION_FACTOR > 1) responsible->dropReplicas(key);
 }
 
 // Print finger table
@@ -280,52 +1056,114 @@ void Node::print_finger_table() {
 
 // Print the keys stored locally on this node
 void Node::print_keys() {
-    std::cout << "Node id:" << (int)id_ << "\n";
+    std::cout << "Node id:" << idToString(id_) << "\n";
     if (localKeys_.empty()) {
         std::cout << "(No keys stored)\n";
     } else {
+        // Print in key order whatever the storage backend
+        std::vector<std::pair<NodeId, const Value*>> entries;
+        localKeys_.forEach([&](const NodeId& key, const Value& value) { entries.emplace_back(key, &value); });
+        std::sort(entries.begin(), entries.end(),
+                  [](const std::pair<NodeId, const Value*>& a, const std::pair<NodeId, const Value*>& b) {
+                      return a.first < b.first;
+                  });
+
         std::cout << "{ ";
-        for (auto& kv : localKeys_) {
-            std::cout << (int)kv.first << ": " 
-                      << (kv.second == -1 ? "None" : std::to_string(kv.second)) << ", ";
+        for (auto& kv : entries) {
+            std::cout << idToString(kv.first) << ": " 
+                      << valueToString(*kv.second) << ", ";
         }
         std::cout << "}\n";
     }
 }
 
 // Periodic stabilize
-void Node::stabilize() {
-    if (successor_ == this) return;
+bool Node::stabilize() {
+    // Migration progress alone does not count as a change
+    if (incoming_.from) continueMigration();
+
+    // A failed predecessor is forgotten; the next notify() replaces it
+    bool predecessorFailed = predecessor_ && !predecessor_->inRing_;
+    if (predecessorFailed) {
+        predecessor_ = nullptr;
+        predecessorLost_ = true;
+    }
+    DHT_METRIC(metrics_.stabilizeCalls++, metrics_.predecessorChanges += predecessorFailed);
+
+    if (successor_ == this) return predecessorFailed;
+
+    Node* oldSuccessor = successor_;
+    successor_ = liveSuccessor();
+    DHT_METRIC(metrics_.stabilizeMessages += successor_ != oldSuccessor);  // The query that timed out
+    if (!successor_) {
+        successor_ = oldSuccessor;  // Cut off: wait for a live node to notify us
+        return predecessorFailed;
+    }
 
     Node* x = successor_->getPredecessor();
-    if (x != nullptr && x != successor_ &&
+    if (x != nullptr && x != successor_ && x->inRing_ &&
         inInterval(x->getId(), id_, successor_->getId(), false, false))
     {
         successor_ = x;
     }
 
+    Node* oldSuccessorPredecessor = successor_->getPredecessor();
     if (successor_->getPredecessor() == nullptr || 
         inInterval(successor_->getPredecessor()->getId(), id_, successor_->getId(), false, false)) {
+        if (!oldSuccessorPredecessor || !oldSuccessorPredecessor->inRing_) successor_->predecessorLost_ = true;
         successor_->setPredecessor(this);
+        DHT_METRIC(successor_->metrics_.predecessorChanges += oldSuccessorPredecessor != this);
     }
 
     successor_->notify(this);
+    Node* oldTargets[REPLICATION_FACTOR] = {};
+    int oldTargetCount = REPLICATION_FACTOR > 1 ? replicaTargets(oldTargets) : 0;
+    bool listChanged = refreshSuccessorList();
+    int copies = 0;
+    if (listChanged && REPLICATION_FACTOR > 1) {
+        dropStaleReplicas(oldTargets, oldTargetCount);
+        copies = repairReplicas();
+    }
+    // Predecessor query, notify and successor list fetch, plus the replica copies
+    DHT_METRIC(metrics_.stabilizeMessages += 3 + (uint64_t)copies,
+               metrics_.successorChanges += successor_ != oldSuccessor);
+    (void)copies;  // Only counted in the metrics
+
+    return predecessorFailed || successor_ != oldSuccessor || listChanged ||
+           successor_->getPredecessor() != oldSuccessorPredecessor;
 }
 
 // notify
 void Node::notify(Node* n) {
-    if (predecessor_ == nullptr || inInterval(n->getId(), predecessor_->getId(), id_, false, false)) {
+    DHT_METRIC(metrics_.notifyCalls++);
+    if (predecessor_ == nullptr || !predecessor_->inRing_ ||
+        inInterval(n->getId(), predecessor_->getId(), id_, false, false)) {
+        if (predecessor_ == nullptr || !predecessor_->inRing_) predecessorLost_ = true;
+        DHT_METRIC(metrics_.predecessorChanges += predecessor_ != n);
         predecessor_ = n;
     }
+    // stabilize() may already have linked n directly. Replicas are only promoted
+    // after a failure: otherwise they may be stale copies of removed keys.
+    if (predecessor_ == n && predecessorLost_) {
+        predecessorLost_ = false;
+        if (promoteReplicas()) repairReplicas();
+    }
 }
 
 // fix_fingers
-void Node::fix_fingers() {
+int Node::fix_fingers() {
+    int changed = 0;
     for (int i = 1; i <= BITLENGTH; i++) {
-        uint16_t start = (id_ + (1 << (i - 1))) % (1 << BITLENGTH);
-        Node* succ = find_successor(start);
+        NodeId start = ChordSpace::fingerStart(id_, i);
+        Node* succ = lookup(start).node;
 
-        fingerTable_.set(i, succ);
+        if (fingerTable_.get(i) != succ) {
+            fingerTable_.set(i, succ);
+            changed++;
+        }
     }
+    DHT_METRIC(metrics_.fixFingersCalls++, metrics_.fingersChanged += (uint64_t)changed,
+               Metrics::global().fingersChangedPerFix.record((uint64_t)changed));
+    return changed;
 }
 
@@ -0,0 +1,33 @@
+#include "node_pool.h"
+#include <new>
+
+NodePool::NodePool() : size_(0) {}
+
+NodePool::~NodePool() {
+    clear();
+}
+
+NodeHandle NodePool::create(NodeId id) {
+    reserve(size_ + 1);
+    NodeHandle handle = (NodeHandle)size_;
+    new (get(handle)) Node(id, this, handle);
+    size_++;
+    return handle;
+}
+
+void NodePool::reserve(size_t n) {
+    while (chunks_.size() * kChunkSize < n) {
+        chunks_.push_back(static_cast<Node*>(::operator new(kChunkSize * sizeof(Node))));
+    }
+}
+
+void NodePool::clear() {
+    for (size_t i = 0; i < size_; i++) {
+        get((NodeHandle)i)->~Node();
+    }
+    for (Node* chunk : chunks_) {
+        ::operator delete(chunk);
+    }
+    chunks_.clear();
+    size_ = 0;
+}
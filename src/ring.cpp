@@ -0,0 +1,440 @@
+#include "ring.h"
+#include "log.h"
+#include "node.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+Ring::Ring() {}
+
+Ring::~Ring() {}
+
+Node* Ring::addNode(NodeId id, HostId host) {
+    Node* node = pool_.get(pool_.create(id));
+    if (host != kNoHost) node->host_ = host;
+    return node;
+}
+
+std::vector<Node*> Ring::nodes() const {
+    std::vector<Node*> all;
+    all.reserve(pool_.size());
+    for (size_t h = 0; h < pool_.size(); ++h) {
+        all.push_back(pool_.get((NodeHandle)h));
+    }
+    return all;
+}
+
+std::vector<Node*> Ring::activeNodes() const {
+    std::vector<Node*> active;
+    active.reserve(pool_.size());
+    for (size_t h = 0; h < pool_.size(); ++h) {
+        Node* node = pool_.get((NodeHandle)h);
+        if (node->isInRing()) active.push_back(node);
+    }
+    return active;
+}
+
+std::vector<Node*> Ring::activeNodesById() const {
+    std::vector<Node*> active = activeNodes();
+    std::sort(active.begin(), active.end(), [](Node* a, Node* b) { return a->getId() < b->getId(); });
+    return active;
+}
+
+int Ring::stabilizeNetwork(RoundMode mode, unsigned threads) {
+    if (mode == RoundMode::Parallel) return stabilizeParallel(threads);
+    std::vector<Node*> active = activeNodes();
+    return Node::stabilizeAll(active);
+}
+
+int Ring::fixAllFingers(RoundMode mode, unsigned threads) {
+    if (mode == RoundMode::Parallel) return fixFingersParallel(threads);
+    std::vector<Node*> active = activeNodes();
+    return Node::fixAllFingers(active);
+}
+
+int Ring::stabilizeParallel(unsigned threads) {
+    std::vector<Node*> active = activeNodes();
+    const size_t n = active.size();
+    const size_t maxRounds = std::max<size_t>(5, n);
+
+    std::vector<Node*> nextSuccessor(n);
+    std::vector<Node*> nextList(n * SUCCESSOR_LIST_LENGTH);              // Row i: successor list of active[i]
+    std::vector<std::atomic<NodeHandle>> nextPredecessor(pool_.size());   // By handle
+
+    // Replica targets before the rounds, to clear the copies left on nodes that drop out
+    std::vector<Node*> oldTargets(REPLICATION_FACTOR > 1 ? n * REPLICATION_FACTOR : 0);
+    std::vector<int> oldTargetCounts(REPLICATION_FACTOR > 1 ? n : 0);
+    for (size_t i = 0; i < oldTargetCounts.size(); ++i) {
+        oldTargetCounts[i] = active[i]->replicaTargets(&oldTargets[i * REPLICATION_FACTOR]);
+    }
+
+    int rounds = 0;
+    bool changed = true;
+    while (changed && (size_t)rounds < maxRounds) {
+        // Streaming key migrations touch two nodes' stores, so they advance serially
+        for (Node* node : active) {
+            if (node->incoming_.from) node->continueMigration();
+        }
+
+        // Failed predecessors are dropped before anyone notifies
+        for (Node* node : active) {
+            Node* p = node->predecessor_;
+            if (!p || !p->inRing_) node->predecessorLost_ = true;
+            nextPredecessor[node->handle_].store(p && p->inRing_ ? p->handle_ : kNullHandle,
+                                                 std::memory_order_relaxed);
+        }
+
+        // Phase 1: links are only read. Each node replaces a failed successor
+        // from its list, adopts its successor's predecessor if closer, then
+        // notifies its (new) successor; the closest notifier wins whatever
+        // order the notifications arrive in.
+        std::atomic<uint64_t> roundMessages(0);
+        parallelFor(n, threads, [&](size_t begin, size_t end) {
+            uint64_t messages = 0;
+            for (size_t i = begin; i < end; ++i) {
+                Node* node = active[i];
+                Node** list = &nextList[i * SUCCESSOR_LIST_LENGTH];
+                Node* successor = node->liveSuccessor();
+#if DHT_METRICS
+                // As in Node::stabilize(): a timed-out probe, then query, notify and list fetch
+                uint64_t sent = (successor != node->successor_) + (successor && successor != node ? 3 : 0);
+                node->metrics_.stabilizeCalls++;
+                node->metrics_.stabilizeMessages += sent;
+                messages += sent;
+#endif
+                if (successor == node || successor == nullptr) {
+                    nextSuccessor[i] = node->successor_;
+                    std::copy(node->successorList_, node->successorList_ + SUCCESSOR_LIST_LENGTH, list);
+                    continue;
+                }
+                Node* x = successor->predecessor_;
+                if (x != nullptr && x != successor && x->inRing_ &&
+                    ChordSpace::inInterval(x->id_, node->id_, successor->id_, false, false)) {
+                    successor = x;
+                }
+                nextSuccessor[i] = successor;
+                list[0] = successor;
+                std::copy(successor->successorList_, successor->successorList_ + SUCCESSOR_LIST_LENGTH - 1,
+                          list + 1);
+
+                std::atomic<NodeHandle>& best = nextPredecessor[successor->handle_];
+                NodeHandle current = best.load(std::memory_order_relaxed);
+                while (current == kNullHandle ||
+                       (current != node->handle_ &&
+                        ChordSpace::inInterval(node->id_, pool_.get(current)->id_, successor->id_, false, false))) {
+                    if (best.compare_exchange_weak(current, node->handle_, std::memory_order_relaxed)) break;
+                }
+            }
+            roundMessages.fetch_add(messages, std::memory_order_relaxed);
+        });
+
+        // Phase 2: commit every link at once
+        std::atomic<bool> anyChange(false);
+        parallelFor(n, threads, [&](size_t begin, size_t end) {
+            bool local = false;
+            for (size_t i = begin; i < end; ++i) {
+                Node* node = active[i];
+                NodeHandle p = nextPredecessor[node->handle_].load(std::memory_order_relaxed);
+                Node* predecessor = p == kNullHandle ? nullptr : pool_.get(p);
+                Node* const* list = &nextList[i * SUCCESSOR_LIST_LENGTH];
+                local |= node->successor_ != nextSuccessor[i] || node->predecessor_ != predecessor ||
+                         !std::equal(list, list + SUCCESSOR_LIST_LENGTH, node->successorList_);
+                DHT_METRIC(node->metrics_.successorChanges += node->successor_ != nextSuccessor[i],
+                           node->metrics_.predecessorChanges += node->predecessor_ != predecessor);
+                node->successor_ = nextSuccessor[i];
+                node->predecessor_ = predecessor;
+                std::copy(list, list + SUCCESSOR_LIST_LENGTH, node->successorList_);
+            }
+            if (local) anyChange.store(true, std::memory_order_relaxed);
+        });
+        changed = anyChange.load();
+        DHT_METRIC(Metrics::global().stabilizeRounds++,
+                   Metrics::global().messagesPerStabilizeRound.record(roundMessages.load()));
+        rounds++;
+    }
+
+    // Replica upkeep writes into other nodes' stores, so it runs once, serially
+    if (REPLICATION_FACTOR > 1) {
+        for (Node* node : active) {
+            if (!node->predecessorLost_ || !node->predecessor_) continue;
+            node->predecessorLost_ = false;
+            node->promoteReplicas();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            active[i]->dropStaleReplicas(&oldTargets[i * REPLICATION_FACTOR], oldTargetCounts[i]);
+        }
+        for (Node* node : active) node->repairReplicas();
+    }
+    return rounds;
+}
+
+int Ring::fixFingersParallel(unsigned threads) {
+    std::vector<Node*> active = activeNodes();
+    const size_t n = active.size();
+    const size_t maxRounds = std::max<size_t>(5, n);
+
+    // Second buffer of finger tables: entry (i, f) is finger f + 1 of active[i]
+    std::vector<Node*> next(n * BITLENGTH);
+
+    int totalChanged = 0;
+    for (size_t round = 0; round < maxRounds; round++) {
+        // Phase 1: lookups read the previous round's tables only
+        parallelFor(n, threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Node* node = active[i];
+                for (int f = 1; f <= BITLENGTH; f++) {
+                    next[i * BITLENGTH + f - 1] = node->lookup(ChordSpace::fingerStart(node->id_, f)).node;
+                }
+                DHT_METRIC(node->metrics_.fixFingersCalls++);
+            }
+        });
+
+        // Phase 2: commit
+        std::atomic<int> changed(0);
+        parallelFor(n, threads, [&](size_t begin, size_t end) {
+            int local = 0;
+            for (size_t i = begin; i < end; ++i) {
+                Node* node = active[i];
+                for (int f = 1; f <= BITLENGTH; f++) {
+                    Node* finger = next[i * BITLENGTH + f - 1];
+                    if (node->fingerTable_.get(f) != finger) {
+                        node->fingerTable_.set(f, finger);
+                        DHT_METRIC(node->metrics_.fingersChanged++);
+                        local++;
+                    }
+                }
+            }
+            changed.fetch_add(local, std::memory_order_relaxed);
+        });
+        totalChanged += changed.load();
+        DHT_METRIC(Metrics::global().fixFingersRounds++,
+                   Metrics::global().fingersChangedPerRound.record((uint64_t)changed.load()));
+        if (changed.load() == 0) break;
+    }
+    return totalChanged;
+}
+
+void Ring::enableLocationCaches(size_t capacity) {
+    for (Node* node : nodes()) {
+        node->enableLocationCache(capacity);
+    }
+}
+
+MetricsSnapshot Ring::metrics() const {
+    MetricsSnapshot snapshot;
+#if DHT_METRICS
+    snapshot.ring = Metrics::global();
+    std::vector<Node*> all = nodes();
+    snapshot.nodes.reserve(all.size());
+    for (Node* node : all) {
+        snapshot.nodes.push_back({node->id_, node->inRing_, node->metrics_});
+        snapshot.total += node->metrics_;
+    }
+#endif
+    return snapshot;
+}
+
+void Ring::resetMetrics() {
+#if DHT_METRICS
+    for (Node* node : nodes()) node->resetMetrics();
+    Metrics::reset();
+#endif
+}
+
+LocationCacheStats Ring::locationCacheStats() const {
+    LocationCacheStats total;
+    for (Node* node : nodes()) {
+        if (node->getLocationCache()) total += node->getLocationCache()->stats;
+    }
+    return total;
+}
+
+bool Ring::bootstrapHosts(std::vector<std::pair<NodeId, HostId>> positions,
+                          std::vector<std::pair<NodeId, Value>> keys, unsigned threads) {
+    if (pool_.size() != 0 || positions.empty()) return false;
+
+    // Same order and de-duplication as bootstrap(), so handle k gets positions[k]
+    std::sort(positions.begin(), positions.end(),
+              [](const std::pair<NodeId, HostId>& a, const std::pair<NodeId, HostId>& b) {
+                  return a.first < b.first;
+              });
+    positions.erase(std::unique(positions.begin(), positions.end(),
+                                [](const std::pair<NodeId, HostId>& a, const std::pair<NodeId, HostId>& b) {
+                                    return a.first == b.first;
+                                }),
+                    positions.end());
+
+    std::vector<NodeId> ids;
+    ids.reserve(positions.size());
+    for (const auto& p : positions) ids.push_back(p.first);
+    bootstrap(std::move(ids), std::move(keys), threads);
+
+    for (size_t k = 0; k < positions.size(); ++k) {
+        pool_.get((NodeHandle)k)->host_ = positions[k].second;
+    }
+    return true;
+}
+
+std::vector<HostLoad> Ring::hostLoads() const {
+    std::unordered_map<HostId, size_t> index;
+    std::vector<HostLoad> loads;
+    for (Node* node : activeNodes()) {
+        auto it = index.emplace(node->host_, loads.size()).first;
+        if (it->second == loads.size()) {
+            loads.push_back(HostLoad());
+            loads.back().host = node->host_;
+        }
+        HostLoad& load = loads[it->second];
+        load.virtualNodes++;
+        load.keys += node->localKeys_.size();
+        load.requests += node->requestsServed_;
+    }
+    std::sort(loads.begin(), loads.end(), [](const HostLoad& a, const HostLoad& b) { return a.host < b.host; });
+    return loads;
+}
+
+std::vector<Node*> Ring::hostNodes(HostId host) const {
+    std::vector<Node*> result;
+    for (Node* node : activeNodes()) {
+        if (node->host_ == host) result.push_back(node);
+    }
+    return result;
+}
+
+int Ring::rebalance(LoadMetric metric, double maxRatio, int maxMoves) {
+    auto nodeLoad = [metric](const Node* node) -> uint64_t {
+        return metric == LoadMetric::Keys ? node->localKeys_.size() : node->requestsServed_;
+    };
+
+    // Hosts and their virtual nodes
+    std::unordered_map<HostId, size_t> index;
+    std::vector<HostId> hosts;
+    std::vector<std::vector<Node*>> members;
+    std::vector<uint64_t> load;
+    uint64_t total = 0;
+    for (Node* node : activeNodes()) {
+        auto it = index.emplace(node->host_, hosts.size()).first;
+        if (it->second == hosts.size()) {
+            hosts.push_back(node->host_);
+            members.emplace_back();
+            load.push_back(0);
+        }
+        members[it->second].push_back(node);
+        load[it->second] += nodeLoad(node);
+        total += nodeLoad(node);
+    }
+    if (hosts.size() < 2) return 0;
+    const double limit = maxRatio * (double)total / hosts.size();
+
+    int moves = 0;
+    while (moves < maxMoves) {
+        size_t busiest = std::max_element(load.begin(), load.end()) - load.begin();
+        size_t idlest = std::min_element(load.begin(), load.end()) - load.begin();
+        if ((double)load[busiest] <= limit || members[busiest].size() < 2) break;
+
+        // The virtual node leaving the two hosts closest to equal, if it helps at all
+        std::vector<Node*>& from = members[busiest];
+        size_t best = from.size();
+        uint64_t bestGap = load[busiest] - load[idlest];
+        for (size_t i = 0; i < from.size(); ++i) {
+            uint64_t v = nodeLoad(from[i]);
+            if (v == 0 || load[idlest] + v >= load[busiest]) continue;
+            uint64_t a = load[busiest] - v;
+            uint64_t b = load[idlest] + v;
+            uint64_t gap = a > b ? a - b : b - a;
+            if (gap < bestGap) {
+                bestGap = gap;
+                best = i;
+            }
+        }
+        if (best == from.size()) break;
+
+        Node* moved = from[best];
+        uint64_t v = nodeLoad(moved);
+        from[best] = from.back();
+        from.pop_back();
+        members[idlest].push_back(moved);
+        load[busiest] -= v;
+        load[idlest] += v;
+        moved->host_ = hosts[idlest];
+        moves++;
+        DHT_LOG_INFO("Node " << idToString(moved->id_) << " moved from host " << hosts[busiest]
+                     << " to host " << hosts[idlest]);
+    }
+    return moves;
+}
+
+void Ring::resetRequestCounts() {
+    for (Node* node : nodes()) {
+        node->requestsServed_ = 0;
+    }
+}
+
+void Ring::printAllKeys() const {
+    for (Node* node : activeNodesById()) {
+        node->print_keys();
+    }
+}
+
+void Ring::printAllFingerTables() const {
+    for (Node* node : activeNodesById()) {
+        node->print_finger_table();
+    }
+}
+
+bool Ring::bootstrap(std::vector<NodeId> ids, std::vector<std::pair<NodeId, Value>> keys,
+                     unsigned threads) {
+    if (pool_.size() != 0 || ids.empty()) return false;
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    const size_t n = ids.size();
+
+    // Handle k is the k-th smallest ID
+    pool_.reserve(n);
+    for (const NodeId& id : ids) {
+        pool_.create(id);
+    }
+
+    // Successor/predecessor links straight from the sorted order
+    for (size_t k = 0; k < n; ++k) {
+        Node* node = pool_.get((NodeHandle)k);
+        node->successor_ = pool_.get((NodeHandle)((k + 1) % n));
+        node->predecessor_ = n > 1 ? pool_.get((NodeHandle)((k + n - 1) % n)) : nullptr;
+        for (size_t r = 0; r < SUCCESSOR_LIST_LENGTH; ++r) {
+            node->successorList_[r] = pool_.get((NodeHandle)((k + 1 + r) % n));
+        }
+        node->inRing_ = true;
+    }
+
+    // Finger i of node k is the first ID >= start, wrapping to the smallest ID
+    auto fillFingers = [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            Node* node = pool_.get((NodeHandle)k);
+            for (int i = 1; i <= BITLENGTH; ++i) {
+                NodeId start = ChordSpace::fingerStart(ids[k], i);
+                size_t j = std::lower_bound(ids.begin(), ids.end(), start) - ids.begin();
+                node->fingerTable_.set(i, pool_.get((NodeHandle)(j == n ? 0 : j)));
+            }
+        }
+    };
+
+    parallelFor(n, threads, fillFingers);
+
+    // Keys sorted by ID; node k owns (ids[k-1], ids[k]], keys past the last ID wrap to node 0
+    std::sort(keys.begin(), keys.end(),
+              [](const std::pair<NodeId, Value>& a, const std::pair<NodeId, Value>& b) {
+                  return a.first < b.first;
+              });
+    size_t k = 0;
+    for (auto& kv : keys) {
+        while (k < n && ids[k] < kv.first) ++k;
+        pool_.get((NodeHandle)(k == n ? 0 : k))->localKeys_.put(kv.first, std::move(kv.second));
+    }
+    if (REPLICATION_FACTOR > 1) {
+        for (size_t h = 0; h < n; ++h) pool_.get((NodeHandle)h)->repairReplicas();
+    }
+    return true;
+}
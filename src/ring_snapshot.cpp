@@ -0,0 +1,354 @@
+#include "ring_snapshot.h"
+#include "log.h"
+#include "parallel.h"
+#include "ring.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+static_assert(std::is_trivially_copyable<NodeId>::value, "snapshots store IDs as raw bytes");
+
+namespace {
+
+const char kMagic[8] = {'D', 'H', 'T', 'R', 'I', 'N', 'G', '\0'};
+const uint32_t kByteOrderMark = 0x01020304u;
+const uint64_t kAlignment = 64;
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// Sequential writer that pads to section offsets
+class SnapshotFile {
+public:
+    explicit SnapshotFile(const std::string& path) : file_(std::fopen(path.c_str(), "wb")), offset_(0), ok_(file_) {
+        if (file_) std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+    }
+    ~SnapshotFile() {
+        if (file_) std::fclose(file_);
+    }
+
+    void write(const void* bytes, size_t size) {
+        if (ok_ && size && std::fwrite(bytes, 1, size, file_) != size) ok_ = false;
+        offset_ += size;
+    }
+
+    void padTo(uint64_t offset) {
+        static const char zeros[kAlignment] = {};
+        while (offset_ < offset) write(zeros, (size_t)std::min<uint64_t>(offset - offset_, kAlignment));
+    }
+
+    bool close() {
+        if (!file_) return false;
+        ok_ &= std::fclose(file_) == 0;
+        file_ = nullptr;
+        return ok_;
+    }
+
+private:
+    std::FILE* file_;
+    uint64_t offset_;
+    bool ok_;
+};
+
+// One node's keys in ID order, with their values
+typedef std::vector<std::pair<NodeId, const Value*>> SortedKeys;
+
+void sortedKeys(const KeyStore<Value>& store, SortedKeys& out) {
+    out.clear();
+    out.reserve(store.size());
+    store.forEach([&](const NodeId& key, const Value& value) { out.emplace_back(key, &value); });
+    auto byKey = [](const std::pair<NodeId, const Value*>& a, const std::pair<NodeId, const Value*>& b) {
+        return a.first < b.first;
+    };
+    if (!std::is_sorted(out.begin(), out.end(), byKey)) std::sort(out.begin(), out.end(), byKey);
+}
+
+}  // namespace
+
+RingSnapshot::RingSnapshot()
+    : base_(nullptr),
+      size_(0),
+      ids_(nullptr),
+      nodes_(nullptr),
+      fingers_(nullptr),
+      successorLists_(nullptr),
+      keys_(nullptr),
+      values_(nullptr),
+      data_(nullptr) {}
+
+RingSnapshot::~RingSnapshot() {
+    close();
+}
+
+void RingSnapshot::close() {
+    if (base_) munmap(const_cast<uint8_t*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+}
+
+bool RingSnapshot::fail(const std::string& message) {
+    close();
+    error_ = message;
+    return false;
+}
+
+bool RingSnapshot::open(const std::string& path) {
+    close();
+    error_.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail("cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        ::close(fd);
+        return fail(path + " is too short for a ring snapshot");
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // The mapping keeps the file alive
+    if (mapped == MAP_FAILED) return fail("cannot map " + path);
+    base_ = static_cast<const uint8_t*>(mapped);
+    size_ = size;
+
+    const Header& h = *header();
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return fail(path + " is not a ring snapshot");
+    if (h.version != kRingSnapshotVersion) {
+        return fail("unsupported ring snapshot version " + std::to_string(h.version));
+    }
+    if (h.byteOrder != kByteOrderMark) return fail("ring snapshot was written with another byte order");
+    if (h.bitLength != BITLENGTH || h.idSize != sizeof(NodeId)) {
+        return fail("ring snapshot has " + std::to_string(h.bitLength) + "-bit IDs, this build uses " +
+                    std::to_string(BITLENGTH));
+    }
+    if (h.successorListLength != SUCCESSOR_LIST_LENGTH) {
+        return fail("ring snapshot has successor lists of " + std::to_string(h.successorListLength) +
+                    ", this build uses " + std::to_string(SUCCESSOR_LIST_LENGTH));
+    }
+    if (h.fileSize != size) return fail("ring snapshot is truncated");
+
+    // Every section must lie inside the file. Counts come from the file, so
+    // they are compared against the room left instead of multiplied out.
+    const uint64_t n = h.nodeCount, keys = h.keyCount;
+    if (n >= kNullHandle) return fail("ring snapshot has too many nodes");
+    struct Section {
+        uint64_t offset;
+        uint64_t count;
+        uint64_t elementSize;
+    } sections[] = {
+        {h.idsOffset, n, sizeof(NodeId)},
+        {h.nodesOffset, n, sizeof(NodeRecord)},
+        {h.fingersOffset, n, BITLENGTH * sizeof(NodeHandle)},
+        {h.successorListsOffset, n, SUCCESSOR_LIST_LENGTH * sizeof(NodeHandle)},
+        {h.keysOffset, keys, sizeof(NodeId)},
+        {h.valuesOffset, keys, sizeof(ValueRecord)},
+        {h.dataOffset, h.dataBytes, 1},
+    };
+    for (const Section& s : sections) {
+        if (s.offset % 8 != 0 || s.offset > size || s.count > (size - s.offset) / s.elementSize) {
+            return fail("ring snapshot has a section outside the file");
+        }
+    }
+    ids_ = reinterpret_cast<const NodeId*>(base_ + h.idsOffset);
+    nodes_ = reinterpret_cast<const NodeRecord*>(base_ + h.nodesOffset);
+    fingers_ = reinterpret_cast<const NodeHandle*>(base_ + h.fingersOffset);
+    successorLists_ = reinterpret_cast<const NodeHandle*>(base_ + h.successorListsOffset);
+    keys_ = reinterpret_cast<const NodeId*>(base_ + h.keysOffset);
+    values_ = reinterpret_cast<const ValueRecord*>(base_ + h.valuesOffset);
+    data_ = base_ + h.dataOffset;
+
+    // Handles and ranges are checked once here, so the accessors and Ring::load() need not
+    for (uint64_t i = 0; i < n; i++) {
+        const NodeRecord& node = nodes_[i];
+        if (node.successor >= n || (node.predecessor != kNullHandle && node.predecessor >= n)) {
+            return fail("ring snapshot node " + std::to_string(i) + " links to a missing node");
+        }
+        if (node.firstKey > keys || (uint64_t)node.ownedKeys + node.replicaKeys > keys - node.firstKey) {
+            return fail("ring snapshot node " + std::to_string(i) + " has keys outside the key section");
+        }
+    }
+    for (uint64_t i = 0; i < n * BITLENGTH; i++) {
+        if (fingers_[i] != kNullHandle && fingers_[i] >= n) return fail("ring snapshot has a finger to a missing node");
+    }
+    for (uint64_t i = 0; i < n * SUCCESSOR_LIST_LENGTH; i++) {
+        if (successorLists_[i] >= n) return fail("ring snapshot has a successor list entry to a missing node");
+    }
+    for (uint64_t i = 0; i < keys; i++) {
+        const ValueRecord& v = values_[i];
+        if (v.offset > h.dataBytes || v.size > h.dataBytes - v.offset) {
+            return fail("ring snapshot has a value outside the data section");
+        }
+    }
+    return true;
+}
+
+bool Ring::save(const std::string& path) const {
+    const size_t n = pool_.size();
+
+    // Sizes first, so every section offset is known before writing
+    uint64_t keys = 0, dataBytes = 0;
+    for (size_t h = 0; h < n; h++) {
+        const Node* node = pool_.get((NodeHandle)h);
+        keys += node->localKeys_.size() + node->replicaKeys_.size();
+        for (const KeyStore<Value>* store : {&node->localKeys_, &node->replicaKeys_}) {
+            store->forEach([&](const NodeId&, const Value& value) {
+                if (value) dataBytes += value->size();
+            });
+        }
+    }
+
+    RingSnapshot::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kRingSnapshotVersion;
+    header.byteOrder = kByteOrderMark;
+    header.bitLength = BITLENGTH;
+    header.idSize = sizeof(NodeId);
+    header.successorListLength = SUCCESSOR_LIST_LENGTH;
+    header.replicationFactor = REPLICATION_FACTOR;
+    header.nodeCount = n;
+    header.keyCount = keys;
+    header.dataBytes = dataBytes;
+    header.idsOffset = alignUp(sizeof(header));
+    header.nodesOffset = alignUp(header.idsOffset + n * sizeof(NodeId));
+    header.fingersOffset = alignUp(header.nodesOffset + n * sizeof(RingSnapshot::NodeRecord));
+    header.successorListsOffset = alignUp(header.fingersOffset + n * BITLENGTH * sizeof(NodeHandle));
+    header.keysOffset = alignUp(header.successorListsOffset + n * SUCCESSOR_LIST_LENGTH * sizeof(NodeHandle));
+    header.valuesOffset = alignUp(header.keysOffset + keys * sizeof(NodeId));
+    header.dataOffset = alignUp(header.valuesOffset + keys * sizeof(RingSnapshot::ValueRecord));
+    header.fileSize = header.dataOffset + dataBytes;
+
+    SnapshotFile file(path);
+    file.write(&header, sizeof(header));
+
+    file.padTo(header.idsOffset);
+    for (size_t h = 0; h < n; h++) file.write(&pool_.get((NodeHandle)h)->id_, sizeof(NodeId));
+
+    file.padTo(header.nodesOffset);
+    uint64_t firstKey = 0;
+    for (size_t h = 0; h < n; h++) {
+        const Node* node = pool_.get((NodeHandle)h);
+        RingSnapshot::NodeRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.host = node->host_;
+        record.successor = node->successor_->handle_;
+        record.predecessor = node->predecessor_ ? node->predecessor_->handle_ : kNullHandle;
+        record.flags = node->inRing_ ? RingSnapshot::kInRing : 0;
+        record.requestsServed = node->requestsServed_;
+        record.firstKey = firstKey;
+        record.ownedKeys = (uint32_t)node->localKeys_.size();
+        record.replicaKeys = (uint32_t)node->replicaKeys_.size();
+        firstKey += record.ownedKeys + record.replicaKeys;
+        file.write(&record, sizeof(record));
+    }
+
+    file.padTo(header.fingersOffset);
+    for (size_t h = 0; h < n; h++) {
+        const FingerTable& fingers = pool_.get((NodeHandle)h)->fingerTable_;
+        NodeHandle row[BITLENGTH];
+        for (int i = 1; i <= BITLENGTH; i++) row[i - 1] = fingers.getHandle(i);
+        file.write(row, sizeof(row));
+    }
+
+    file.padTo(header.successorListsOffset);
+    for (size_t h = 0; h < n; h++) {
+        const Node* node = pool_.get((NodeHandle)h);
+        NodeHandle row[SUCCESSOR_LIST_LENGTH];
+        for (int k = 0; k < SUCCESSOR_LIST_LENGTH; k++) row[k] = node->successorList_[k]->handle_;
+        file.write(row, sizeof(row));
+    }
+
+    // Keys, then value records, in the same order: node by node, owned keys before replicas
+    SortedKeys sorted;
+    file.padTo(header.keysOffset);
+    for (size_t h = 0; h < n; h++) {
+        const Node* node = pool_.get((NodeHandle)h);
+        for (const KeyStore<Value>* store : {&node->localKeys_, &node->replicaKeys_}) {
+            sortedKeys(*store, sorted);
+            for (const auto& kv : sorted) file.write(&kv.first, sizeof(NodeId));
+        }
+    }
+    file.padTo(header.valuesOffset);
+    uint64_t dataOffset = 0;
+    for (size_t h = 0; h < n; h++) {
+        const Node* node = pool_.get((NodeHandle)h);
+        for (const KeyStore<Value>* store : {&node->localKeys_, &node->replicaKeys_}) {
+            sortedKeys(*store, sorted);
+            for (const auto& kv : sorted) {
+                RingSnapshot::ValueRecord record = {dataOffset, 0, 0};
+                if (*kv.second) {
+                    record.size = (uint32_t)(*kv.second)->size();
+                    record.flags = RingSnapshot::kHasValue;
+                    dataOffset += record.size;
+                }
+                file.write(&record, sizeof(record));
+            }
+        }
+    }
+    file.padTo(header.dataOffset);
+    for (size_t h = 0; h < n; h++) {
+        const Node* node = pool_.get((NodeHandle)h);
+        for (const KeyStore<Value>* store : {&node->localKeys_, &node->replicaKeys_}) {
+            sortedKeys(*store, sorted);
+            for (const auto& kv : sorted) {
+                if (*kv.second) file.write((*kv.second)->data(), (*kv.second)->size());
+            }
+        }
+    }
+
+    if (!file.close()) {
+        DHT_LOG_ERROR("Could not write ring snapshot " << path);
+        return false;
+    }
+    return true;
+}
+
+bool Ring::load(const RingSnapshot& snapshot, unsigned threads) {
+    if (pool_.size() != 0 || !snapshot.isOpen()) return false;
+    const size_t n = snapshot.nodeCount();
+
+    // Handle h of the snapshot becomes handle h of this ring
+    pool_.reserve(n);
+    for (size_t h = 0; h < n; h++) {
+        pool_.create(snapshot.ids_[h]);
+    }
+
+    // Nodes only write their own state, so they fill in parallel
+    parallelFor(n, threads, [&](size_t begin, size_t end) {
+        for (size_t h = begin; h < end; h++) {
+            Node* node = pool_.get((NodeHandle)h);
+            const RingSnapshot::NodeRecord& record = snapshot.nodes_[h];
+            node->host_ = record.host;
+            node->successor_ = pool_.get(record.successor);
+            node->predecessor_ = record.predecessor == kNullHandle ? nullptr : pool_.get(record.predecessor);
+            node->inRing_ = (record.flags & RingSnapshot::kInRing) != 0;
+            node->requestsServed_ = record.requestsServed;
+
+            const NodeHandle* list = snapshot.successorLists_ + h * SUCCESSOR_LIST_LENGTH;
+            for (int k = 0; k < SUCCESSOR_LIST_LENGTH; k++) node->successorList_[k] = pool_.get(list[k]);
+
+            const NodeHandle* fingers = snapshot.fingers_ + h * BITLENGTH;
+            for (int i = 1; i <= BITLENGTH; i++) {
+                NodeHandle f = fingers[i - 1];
+                node->fingerTable_.set(i, f, f == kNullHandle ? node->id_ : snapshot.ids_[f]);
+            }
+
+            // Keys arrive sorted, so each put appends
+            uint64_t k = record.firstKey;
+            for (uint64_t end = k + record.ownedKeys + record.replicaKeys; k < end; k++) {
+                const RingSnapshot::ValueRecord& v = snapshot.values_[k];
+                Value value;
+                if (v.flags & RingSnapshot::kHasValue) value = Blob(snapshot.data_ + v.offset, v.size);
+                KeyStore<Value>& store = k < record.firstKey + record.ownedKeys ? node->localKeys_ : node->replicaKeys_;
+                store.put(snapshot.keys_[k], std::move(value));
+            }
+        }
+    });
+    return true;
+}
@@ -0,0 +1,284 @@
+#include "simulator.h"
+#include "key_store.h"
+#include "node.h"
+#include "node_pool.h"
+#include "ring.h"
+#include <algorithm>
+
+namespace {
+
+const uint32_t kNoLookup = 0xFFFFFFFFu;
+
+SimTime percentile(const std::vector<SimTime>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+}  // namespace
+
+void SimReport::print(std::ostream& out) const {
+    out << "events=" << events << " messages=" << messagesSent << " lost=" << messagesLost << "\n"
+        << "lookups issued=" << lookupsIssued << " completed=" << lookupsCompleted
+        << " failed=" << lookupsFailed << " mean_hops=" << meanHops << "\n"
+        << "latency_us mean=" << meanLatencyUs << " p50=" << p50Us << " p90=" << p90Us
+        << " p99=" << p99Us << " p99.9=" << p999Us << " max=" << maxUs << "\n"
+        << "virtual_time_us=" << endTimeUs << "\n";
+}
+
+Simulator::Simulator(Ring& ring, const SimConfig& config)
+    : ring_(ring),
+      config_(config),
+      rng_(config.seed),
+      now_(0),
+      maintenanceUntil_(0),
+      seq_(0),
+      events_(0),
+      messagesSent_(0),
+      messagesLost_(0),
+      lookupsIssued_(0),
+      lookupsFailed_(0),
+      completedHops_(0)
+{
+}
+
+void Simulator::push(SimTime time, MsgType type, NodeHandle src, NodeHandle dst, uint32_t lookup,
+                     NodeHandle arg) {
+    Event e;
+    e.time = time;
+    e.seq = seq_++;
+    e.lookup = lookup;
+    e.generation = lookup == kNoLookup ? 0 : lookups_[lookup].generation;
+    e.src = src;
+    e.dst = dst;
+    e.arg = arg;
+    e.type = type;
+    queue_.push(e);
+}
+
+// A message over the link src -> dst: delayed by the link model, possibly lost
+void Simulator::send(MsgType type, NodeHandle src, NodeHandle dst, uint32_t lookup, NodeHandle arg) {
+    if (src != dst) {
+        messagesSent_++;
+        if (config_.link.lossRate > 0 &&
+            std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < config_.link.lossRate) {
+            messagesLost_++;
+            return;
+        }
+    }
+    push(now_ + linkLatency(src, dst), type, src, dst, lookup, arg);
+}
+
+SimTime Simulator::linkLatency(NodeHandle src, NodeHandle dst) {
+    if (src == dst) return 0;
+    const LinkModel& link = config_.link;
+    uint64_t pair = ((uint64_t)std::min(src, dst) << 32) | std::max(src, dst);
+    SimTime latency = link.baseUs + mixId(pair) % (link.spreadUs + 1);
+    if (link.jitterUs > 0) latency += rng_() % (link.jitterUs + 1);
+    return latency;
+}
+
+uint32_t Simulator::startLookup(SimTime at, NodeHandle origin, NodeId key, uint8_t finger) {
+    uint32_t slot;
+    if (!freeLookups_.empty()) {
+        slot = freeLookups_.back();
+        freeLookups_.pop_back();
+        lookups_[slot].generation++;
+    } else {
+        slot = (uint32_t)lookups_.size();
+        lookups_.push_back(Lookup());
+        lookups_[slot].generation = 0;
+    }
+
+    Lookup& l = lookups_[slot];
+    l.start = at;
+    l.key = key;
+    l.origin = origin;
+    l.hops = 0;
+    l.finger = finger;
+    l.done = 0;
+
+    // The origin routes the first hop itself, then gives up after the timeout
+    push(at, FindSuccessor, origin, origin, slot, kNullHandle);
+    push(at + config_.lookupTimeoutUs, LookupTimeout, origin, origin, slot, kNullHandle);
+    return slot;
+}
+
+bool Simulator::isCurrent(const Event& e) const {
+    return e.lookup != kNoLookup && lookups_[e.lookup].generation == e.generation &&
+           !lookups_[e.lookup].done;
+}
+
+void Simulator::scheduleLookup(SimTime at, Node* origin, NodeId key) {
+    lookupsIssued_++;
+    startLookup(std::max(at, now_), origin->getHandle(), key, 0);
+}
+
+void Simulator::startMaintenance(SimTime untilUs) {
+    maintenanceUntil_ = untilUs;
+    std::vector<Node*> active = ring_.activeNodes();
+    for (Node* node : active) {
+        // Random phases so the nodes' timers do not fire in lockstep
+        SimTime stabilizeAt = now_ + rng_() % std::max<SimTime>(1, config_.stabilizeIntervalUs);
+        SimTime fixAt = now_ + rng_() % std::max<SimTime>(1, config_.fixFingerIntervalUs);
+        if (stabilizeAt <= untilUs) {
+            push(stabilizeAt, StabilizeTimer, node->getHandle(), node->getHandle(), kNoLookup, kNullHandle);
+        }
+        if (fixAt <= untilUs) {
+            push(fixAt, FixFingerTimer, node->getHandle(), node->getHandle(), kNoLookup, kNullHandle);
+        }
+    }
+}
+
+void Simulator::run(SimTime untilUs) {
+    while (!queue_.empty() && queue_.top().time <= untilUs) {
+        Event e = queue_.top();
+        queue_.pop();
+        now_ = e.time;
+        events_++;
+        dispatch(e);
+    }
+}
+
+void Simulator::dispatch(const Event& e) {
+    switch (e.type) {
+        case FindSuccessor:    onFindSuccessor(e); break;
+        case LookupReply:      onLookupReply(e); break;
+        case LookupTimeout:    onLookupTimeout(e); break;
+        case GetPredecessor:   onGetPredecessor(e); break;
+        case PredecessorReply: onPredecessorReply(e); break;
+        case Notify:           onNotify(e); break;
+        case StabilizeTimer:   onStabilizeTimer(e); break;
+        case FixFingerTimer:   onFixFingerTimer(e); break;
+    }
+}
+
+// One routing step of find_successor at node e.dst (same rules as Node::lookup)
+void Simulator::onFindSuccessor(const Event& e) {
+    if (!isCurrent(e)) return;
+    Node* n = ring_.node(e.dst);
+    if (!n->isInRing()) return;  // A departed node swallows the message
+
+    Lookup& l = lookups_[e.lookup];
+    Node* result = nullptr;
+    if (l.key == n->id_) {
+        result = n;
+    } else if (n->inInterval(l.key, n->id_, n->successor_->getId(), false, true)) {
+        result = n->successor_;
+    }
+
+    if (result) {
+        send(LookupReply, e.dst, l.origin, e.lookup, result->getHandle());
+        return;
+    }
+
+    Node* next = n->closest_preceding_finger(l.key);
+    if (next == n) next = n->successor_;
+    l.hops++;
+    send(FindSuccessor, e.dst, next->getHandle(), e.lookup, kNullHandle);
+}
+
+void Simulator::onLookupReply(const Event& e) {
+    if (!isCurrent(e)) return;
+    Lookup& l = lookups_[e.lookup];
+    l.done = 1;
+
+    if (l.finger) {
+        ring_.node(l.origin)->fingerTable_.set(l.finger, ring_.node(e.arg));
+    } else {
+        latencies_.push_back(now_ - l.start);
+        completedHops_ += l.hops;
+    }
+}
+
+void Simulator::onLookupTimeout(const Event& e) {
+    if (lookups_[e.lookup].generation != e.generation) return;
+    Lookup& l = lookups_[e.lookup];
+    if (!l.done) {
+        l.done = 1;
+        if (!l.finger) lookupsFailed_++;
+    }
+    // No message of this generation is acted on any more; recycle the slot
+    freeLookups_.push_back(e.lookup);
+}
+
+// stabilize(), step 1: ask the successor for its predecessor
+void Simulator::onStabilizeTimer(const Event& e) {
+    Node* n = ring_.node(e.dst);
+    if (!n->isInRing()) return;
+
+    if (n->successor_ != n) {
+        send(GetPredecessor, e.dst, n->successor_->getHandle(), kNoLookup, kNullHandle);
+    }
+    if (now_ + config_.stabilizeIntervalUs <= maintenanceUntil_) {
+        push(now_ + config_.stabilizeIntervalUs, StabilizeTimer, e.dst, e.dst, kNoLookup, kNullHandle);
+    }
+}
+
+void Simulator::onGetPredecessor(const Event& e) {
+    Node* s = ring_.node(e.dst);
+    if (!s->isInRing()) return;
+    send(PredecessorReply, e.dst, e.src, kNoLookup,
+         s->predecessor_ ? s->predecessor_->getHandle() : kNullHandle);
+}
+
+// stabilize(), step 2: adopt the successor's predecessor if closer, then notify
+void Simulator::onPredecessorReply(const Event& e) {
+    Node* n = ring_.node(e.dst);
+    if (!n->isInRing()) return;
+
+    // Only trust the answer if it came from the current successor
+    if (e.arg != kNullHandle && n->successor_->getHandle() == e.src) {
+        Node* x = ring_.node(e.arg);
+        if (x->isInRing() && n->inInterval(x->id_, n->id_, n->successor_->getId(), false, false)) {
+            n->successor_ = x;
+        }
+    }
+    send(Notify, e.dst, n->successor_->getHandle(), kNoLookup, kNullHandle);
+}
+
+void Simulator::onNotify(const Event& e) {
+    Node* s = ring_.node(e.dst);
+    if (!s->isInRing()) return;
+    s->notify(ring_.node(e.src));
+}
+
+// fix_fingers(): refresh one finger per period through a regular lookup
+void Simulator::onFixFingerTimer(const Event& e) {
+    Node* n = ring_.node(e.dst);
+    if (!n->isInRing()) return;
+
+    int i = (int)n->nextFingerToFix_;
+    n->nextFingerToFix_ = (size_t)(i % BITLENGTH + 1);
+    startLookup(now_, e.dst, ChordSpace::fingerStart(n->id_, i), (uint8_t)i);
+
+    if (now_ + config_.fixFingerIntervalUs <= maintenanceUntil_) {
+        push(now_ + config_.fixFingerIntervalUs, FixFingerTimer, e.dst, e.dst, kNoLookup, kNullHandle);
+    }
+}
+
+SimReport Simulator::report() const {
+    SimReport r;
+    r.events = events_;
+    r.messagesSent = messagesSent_;
+    r.messagesLost = messagesLost_;
+    r.lookupsIssued = lookupsIssued_;
+    r.lookupsCompleted = latencies_.size();
+    r.lookupsFailed = lookupsFailed_;
+    r.endTimeUs = now_;
+
+    if (!latencies_.empty()) {
+        std::vector<SimTime> sorted(latencies_);
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (SimTime t : sorted) sum += (double)t;
+        r.meanLatencyUs = sum / sorted.size();
+        r.meanHops = (double)completedHops_ / sorted.size();
+        r.p50Us = percentile(sorted, 0.50);
+        r.p90Us = percentile(sorted, 0.90);
+        r.p99Us = percentile(sorted, 0.99);
+        r.p999Us = percentile(sorted, 0.999);
+        r.maxUs = sorted.back();
+    }
+    return r;
+}
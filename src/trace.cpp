@@ -0,0 +1,447 @@
+#include "trace.h"
+#include <string.h>
+#include <algorithm>
+#include "log.h"
+#include "node.h"
+#include "ring.h"
+
+namespace {
+
+const char kMagic[8] = {'D', 'H', 'T', 'T', 'R', 'A', 'C', 'E'};
+const uint8_t kVersion = 1;
+const uint8_t kHasOrigin = 0x10;
+const uint8_t kHasValue = 0x20;
+const int kIdBytes = (BITLENGTH + 7) / 8;
+const size_t kBufferSize = 1 << 16;
+
+const char* const kOpNames[] = {"", "join", "leave", "insert", "remove", "lookup", "stabilize", "fix_fingers"};
+
+// Big-endian, `size` bytes (the low bytes of the ID)
+void idToBytes(const NodeId& id, uint8_t* out, int size) {
+#if BITLENGTH == 160
+    uint8_t full[20];
+    for (int i = 0; i < 5; ++i) {
+        uint32_t limb = id.limb(4 - i);
+        for (int j = 0; j < 4; ++j) full[4 * i + j] = (uint8_t)(limb >> (24 - 8 * j));
+    }
+    memcpy(out, full + 20 - size, size);
+#else
+    for (int i = 0; i < size; ++i) out[i] = (uint8_t)((uint64_t)id >> (8 * (size - 1 - i)));
+#endif
+}
+
+NodeId idFromBytes(const uint8_t* bytes, int size) {
+#if BITLENGTH == 160
+    uint8_t full[20] = {0};
+    memcpy(full + 20 - size, bytes, size);
+    return Uint160::fromBytes(full);
+#else
+    uint64_t v = 0;
+    for (int i = 0; i < size; ++i) v = (v << 8) | bytes[i];
+    return (NodeId)v;
+#endif
+}
+
+// Decimal ID; false if it is not a number below 2^BITLENGTH
+bool parseId(const std::string& text, NodeId& id) {
+    if (text.empty()) return false;
+#if BITLENGTH == 160
+    Uint160 v;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        // v * 10 + digit, failing on wrap-around
+        Uint160 v2 = v + v, v4 = v2 + v2, v8 = v4 + v4, v10 = v8 + v2;
+        if (v2 < v || v4 < v2 || v8 < v4 || v10 < v8) return false;
+        Uint160 next = v10 + Uint160((uint64_t)(c - '0'));
+        if (next < v10) return false;
+        v = next;
+    }
+    id = v;
+#else
+    uint64_t v = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        if (v > (~(uint64_t)0 - (uint64_t)(c - '0')) / 10) return false;
+        v = v * 10 + (uint64_t)(c - '0');
+    }
+    if (BITLENGTH < 64 && (v >> (BITLENGTH % 64)) != 0) return false;
+    id = (NodeId)v;
+#endif
+    return true;
+}
+
+bool needsEscape(uint8_t c) {
+    return c <= ' ' || c >= 0x7F || c == '%' || c == '#' || c == '@';
+}
+
+std::string escapeValue(const Blob& blob) {
+    static const char kHex[] = "0123456789ABCDEF";
+    if (blob.size() == 1 && blob.data()[0] == '-') return "%2D";
+    std::string text;
+    for (size_t i = 0; i < blob.size(); ++i) {
+        uint8_t c = blob.data()[i];
+        if (needsEscape(c)) {
+            text += '%';
+            text += kHex[c >> 4];
+            text += kHex[c & 15];
+        } else {
+            text += (char)c;
+        }
+    }
+    return text;
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool unescapeValue(const std::string& text, std::string& bytes) {
+    bytes.clear();
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '%') {
+            bytes += text[i];
+            continue;
+        }
+        if (i + 2 >= text.size()) return false;
+        int hi = hexDigit(text[i + 1]), lo = hexDigit(text[i + 2]);
+        if (hi < 0 || lo < 0) return false;
+        bytes += (char)(hi * 16 + lo);
+        i += 2;
+    }
+    return true;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// TraceReader
+
+TraceReader::TraceReader(std::istream& in)
+    : in_(in), buffer_(kBufferSize), pos_(0), end_(0), format_(TraceFormat::Text),
+      idBytes_(kIdBytes), records_(0), line_(0) {
+    // A binary trace starts with the magic; anything else is text
+    while (end_ < sizeof(kMagic) && fill()) {
+    }
+    if (end_ - pos_ < sizeof(kMagic) || memcmp(buffer_.data() + pos_, kMagic, sizeof(kMagic)) != 0) return;
+    format_ = TraceFormat::Binary;
+    pos_ += sizeof(kMagic);
+
+    uint8_t header[4];
+    if (!readBytes(header, sizeof(header))) {
+        fail("truncated header");
+        return;
+    }
+    int bits = header[2] | (header[3] << 8);
+    if (header[0] != kVersion) {
+        fail("unsupported version " + std::to_string(header[0]));
+    } else if (bits < 1 || bits > BITLENGTH) {
+        fail("trace has " + std::to_string(bits) + "-bit IDs, this build " + std::to_string(BITLENGTH));
+    }
+    idBytes_ = (bits + 7) / 8;
+}
+
+// Appends more input after the unread bytes; false at the end of the stream
+bool TraceReader::fill() {
+    if (pos_ > 0) {
+        memmove(buffer_.data(), buffer_.data() + pos_, end_ - pos_);
+        end_ -= pos_;
+        pos_ = 0;
+    }
+    if (end_ == buffer_.size() || !in_) return false;
+    in_.read(buffer_.data() + end_, (std::streamsize)(buffer_.size() - end_));
+    size_t got = (size_t)in_.gcount();
+    end_ += got;
+    return got > 0;
+}
+
+bool TraceReader::readByte(uint8_t& byte) {
+    if (pos_ == end_ && !fill()) return false;
+    byte = (uint8_t)buffer_[pos_++];
+    return true;
+}
+
+bool TraceReader::readBytes(void* out, size_t size) {
+    uint8_t* dst = (uint8_t*)out;
+    while (size > 0) {
+        if (pos_ == end_ && !fill()) return false;
+        size_t n = std::min(size, end_ - pos_);
+        memcpy(dst, buffer_.data() + pos_, n);
+        pos_ += n;
+        dst += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool TraceReader::readLine(std::string& line) {
+    line.clear();
+    while (true) {
+        if (pos_ == end_ && !fill()) return !line.empty();
+        const char* begin = buffer_.data() + pos_;
+        const char* newline = (const char*)memchr(begin, '\n', end_ - pos_);
+        size_t n = newline ? (size_t)(newline - begin) : end_ - pos_;
+        line.append(begin, n);
+        pos_ += n;
+        if (newline) {
+            pos_++;
+            return true;
+        }
+    }
+}
+
+bool TraceReader::fail(const std::string& message) {
+    if (error_.empty()) {
+        error_ = format_ == TraceFormat::Text ? "line " + std::to_string(line_) + ": " + message
+                                              : "record " + std::to_string(records_ + 1) + ": " + message;
+    }
+    return false;
+}
+
+bool TraceReader::next(TraceOp& op) {
+    if (!error_.empty()) return false;
+    bool ok = format_ == TraceFormat::Text ? nextText(op) : nextBinary(op);
+    if (ok) records_++;
+    return ok;
+}
+
+bool TraceReader::nextText(TraceOp& op) {
+    std::string line;
+    std::vector<std::string> tokens;
+    while (true) {
+        if (!readLine(line)) return false;
+        line_++;
+        tokens.clear();
+        size_t i = 0;
+        while (i < line.size()) {
+            while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) i++;
+            if (i == line.size() || line[i] == '#') break;
+            size_t start = i;
+            while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') i++;
+            tokens.push_back(line.substr(start, i - start));
+        }
+        if (!tokens.empty()) break;
+    }
+
+    op = TraceOp();
+    int type = 0;
+    for (int t = 1; t <= (int)TraceOpType::FixFingers; ++t) {
+        if (tokens[0] == kOpNames[t]) type = t;
+    }
+    if (type == 0) return fail("unknown operation '" + tokens[0] + "'");
+    op.type = (TraceOpType)type;
+
+    // Trailing @origin
+    if (tokens.size() > 1 && tokens.back()[0] == '@') {
+        if (op.type == TraceOpType::Leave || op.type == TraceOpType::Stabilize || op.type == TraceOpType::FixFingers) {
+            return fail("'" + tokens[0] + "' takes no origin");
+        }
+        if (!parseId(tokens.back().substr(1), op.origin)) return fail("bad origin '" + tokens.back() + "'");
+        op.hasOrigin = true;
+        tokens.pop_back();
+    }
+
+    size_t args = op.type == TraceOpType::Stabilize || op.type == TraceOpType::FixFingers ? 0 : 1;
+    size_t maxArgs = op.type == TraceOpType::Insert ? 2 : args;
+    if (tokens.size() - 1 < args || tokens.size() - 1 > maxArgs) return fail("wrong number of arguments");
+    if (args && !parseId(tokens[1], op.id)) return fail("bad ID '" + tokens[1] + "'");
+    if (tokens.size() == 3 && tokens[2] != "-") {
+        std::string bytes;
+        if (!unescapeValue(tokens[2], bytes)) return fail("bad escape in value '" + tokens[2] + "'");
+        op.value = Blob(bytes);
+    }
+    return true;
+}
+
+bool TraceReader::nextBinary(TraceOp& op) {
+    uint8_t head;
+    if (!readByte(head)) return false;
+    int type = head & 0x0F;
+    if (type < 1 || type > (int)TraceOpType::FixFingers) return fail("unknown operation " + std::to_string(type));
+
+    op = TraceOp();
+    op.type = (TraceOpType)type;
+    uint8_t bytes[20];
+    if (op.type != TraceOpType::Stabilize && op.type != TraceOpType::FixFingers) {
+        if (!readBytes(bytes, idBytes_)) return fail("truncated record");
+        op.id = idFromBytes(bytes, idBytes_);
+    }
+    if (head & kHasOrigin) {
+        if (!readBytes(bytes, idBytes_)) return fail("truncated record");
+        op.origin = idFromBytes(bytes, idBytes_);
+        op.hasOrigin = true;
+    }
+    if (head & kHasValue) {
+        uint64_t size = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t b;
+            if (shift > 35 || !readByte(b)) return fail("bad value length");
+            size |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        // Grown one buffer at a time, so a corrupt length fails on the short read instead of allocating it
+        std::string value;
+        while (value.size() < size) {
+            size_t at = value.size();
+            size_t piece = (size_t)std::min<uint64_t>(size - at, buffer_.size());
+            value.resize(at + piece);
+            if (!readBytes(&value[at], piece)) return fail("truncated value");
+        }
+        op.value = Blob(value);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// TraceWriter
+
+TraceWriter::TraceWriter(std::ostream& out, TraceFormat format) : out_(out), format_(format), records_(0) {
+    if (format_ == TraceFormat::Binary) {
+        uint8_t header[4] = {kVersion, 0, (uint8_t)(BITLENGTH & 0xFF), (uint8_t)(BITLENGTH >> 8)};
+        out_.write(kMagic, sizeof(kMagic));
+        out_.write((const char*)header, sizeof(header));
+    }
+}
+
+void TraceWriter::write(const TraceOp& op) {
+    bool hasId = op.type != TraceOpType::Stabilize && op.type != TraceOpType::FixFingers;
+    bool hasValue = op.type == TraceOpType::Insert && op.value.has_value();
+    records_++;
+
+    if (format_ == TraceFormat::Text) {
+        out_ << kOpNames[(int)op.type];
+        if (hasId) out_ << ' ' << idToString(op.id);
+        if (hasValue) out_ << ' ' << escapeValue(*op.value);
+        if (op.hasOrigin) out_ << " @" << idToString(op.origin);
+        out_ << '\n';
+        return;
+    }
+
+    uint8_t record[2 + 2 * 20 + 10];
+    size_t n = 0;
+    record[n++] = (uint8_t)((int)op.type | (op.hasOrigin ? kHasOrigin : 0) | (hasValue ? kHasValue : 0));
+    if (hasId) {
+        idToBytes(op.id, record + n, kIdBytes);
+        n += kIdBytes;
+    }
+    if (op.hasOrigin) {
+        idToBytes(op.origin, record + n, kIdBytes);
+        n += kIdBytes;
+    }
+    if (hasValue) {
+        uint64_t size = op.value->size();
+        do {
+            record[n++] = (uint8_t)((size & 0x7F) | (size > 0x7F ? 0x80 : 0));
+            size >>= 7;
+        } while (size);
+    }
+    out_.write((const char*)record, (std::streamsize)n);
+    if (hasValue) out_.write((const char*)op.value->data(), (std::streamsize)op.value->size());
+}
+
+// ---------------------------------------------------------------------------
+// TraceRunner
+
+TraceRunner::TraceRunner(Ring& ring, TraceWriter* recorder) : ring_(ring), recorder_(recorder) {
+    for (Node* n : ring_.activeNodes()) live_[n->getId()] = n;
+}
+
+Node* TraceRunner::node(const NodeId& id) const {
+    auto it = live_.find(id);
+    return it == live_.end() ? nullptr : it->second;
+}
+
+Node* TraceRunner::origin(const TraceOp& op) const {
+    if (op.hasOrigin) return node(op.origin);
+    return live_.empty() ? nullptr : live_.begin()->second;
+}
+
+bool TraceRunner::apply(TraceOp& op) {
+    // Validate first, so skipped records are not recorded
+    Node* from = nullptr;
+    Node* target = nullptr;
+    switch (op.type) {
+    case TraceOpType::Join:
+        from = origin(op);
+        if (node(op.id) || (op.hasOrigin && !from)) {
+            stats_.skipped++;
+            return false;
+        }
+        break;
+    case TraceOpType::Leave:
+        target = node(op.id);
+        if (!target) {
+            stats_.skipped++;
+            return false;
+        }
+        break;
+    case TraceOpType::Insert:
+    case TraceOpType::Remove:
+    case TraceOpType::Lookup:
+        from = origin(op);
+        if (!from) {
+            stats_.skipped++;
+            return false;
+        }
+        break;
+    case TraceOpType::Stabilize:
+    case TraceOpType::FixFingers:
+        break;
+    }
+
+    if (from) {
+        op.hasOrigin = true;
+        op.origin = from->getId();
+    }
+    if (recorder_) recorder_->write(op);
+    stats_.applied++;
+
+    switch (op.type) {
+    case TraceOpType::Join: {
+        Node* joining = ring_.addNode(op.id);
+        joining->join(from);
+        if (joining->isInRing()) live_[op.id] = joining;
+        stats_.joins++;
+        break;
+    }
+    case TraceOpType::Leave:
+        target->leave();
+        live_.erase(op.id);
+        stats_.leaves++;
+        break;
+    case TraceOpType::Insert:
+        from->insert(op.id, std::move(op.value));
+        stats_.inserts++;
+        break;
+    case TraceOpType::Remove:
+        from->removeKey(op.id);
+        stats_.removes++;
+        break;
+    case TraceOpType::Lookup: {
+        LookupResult result = from->lookup(op.id);
+        if (!result.node) stats_.unresolved++;
+        stats_.lookupHops += result.hops;
+        stats_.lookups++;
+        break;
+    }
+    case TraceOpType::Stabilize:
+        stats_.stabilizeRounds += ring_.stabilizeNetwork();
+        break;
+    case TraceOpType::FixFingers:
+        stats_.fingersChanged += ring_.fixAllFingers();
+        break;
+    }
+    return true;
+}
+
+bool TraceRunner::run(TraceReader& reader) {
+    TraceOp op;
+    while (reader.next(op)) apply(op);
+    if (!reader.error().empty()) {
+        DHT_LOG_ERROR("Trace stopped at " << reader.error());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#include "value.h"
+#include <cstring>
+#include <new>
+
+namespace {
+
+// RAII guard for the allocator's spin lock
+class SpinGuard {
+public:
+    explicit SpinGuard(std::atomic_flag& flag) : flag_(flag) {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+        }
+    }
+    ~SpinGuard() { flag_.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag& flag_;
+};
+
+}  // namespace
+
+SlabAllocator::SlabAllocator() : bytesInUse_(0), slabCount_(0) {
+    for (int i = 0; i < kNumClasses; ++i) {
+        freeLists_[i] = nullptr;
+    }
+}
+
+SlabAllocator::~SlabAllocator() {
+    for (char* slab : slabs_) {
+        ::operator delete(slab);
+    }
+}
+
+SlabAllocator& SlabAllocator::instance() {
+    // Never destroyed, so values held by static objects stay valid at exit
+    static SlabAllocator* allocator = new SlabAllocator();
+    return *allocator;
+}
+
+// Index of the smallest class holding `bytes`, or -1 for oversized requests
+int SlabAllocator::sizeClass(size_t bytes) {
+    if (bytes > kMaxClassBytes) return -1;
+    int cls = 0;
+    size_t classBytes = kMinClassBytes;
+    while (classBytes < bytes) {
+        classBytes <<= 1;
+        ++cls;
+    }
+    return cls;
+}
+
+// Carve a fresh slab into blocks of class `cls`
+void SlabAllocator::refill(int cls) {
+    size_t blockBytes = kMinClassBytes << cls;
+    char* slab = static_cast<char*>(::operator new(kSlabBytes));
+    slabs_.push_back(slab);
+    slabCount_.fetch_add(1, std::memory_order_relaxed);
+
+    for (size_t offset = 0; offset + blockBytes <= kSlabBytes; offset += blockBytes) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+        block->next = freeLists_[cls];
+        freeLists_[cls] = block;
+    }
+}
+
+void* SlabAllocator::allocate(size_t bytes) {
+    int cls = sizeClass(bytes);
+    if (cls < 0) {
+        return ::operator new(bytes);
+    }
+
+    SpinGuard guard(lock_);
+    if (!freeLists_[cls]) refill(cls);
+    FreeBlock* block = freeLists_[cls];
+    freeLists_[cls] = block->next;
+    bytesInUse_.fetch_add(kMinClassBytes << cls, std::memory_order_relaxed);
+    return block;
+}
+
+void SlabAllocator::deallocate(void* p, size_t bytes) {
+    if (!p) return;
+    int cls = sizeClass(bytes);
+    if (cls < 0) {
+        ::operator delete(p);
+        return;
+    }
+
+    SpinGuard guard(lock_);
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = freeLists_[cls];
+    freeLists_[cls] = block;
+    bytesInUse_.fetch_sub(kMinClassBytes << cls, std::memory_order_relaxed);
+}
+
+Blob::Blob(const void* bytes, size_t size) : data_(nullptr), size_(size) {
+    if (size_ > 0) {
+        data_ = static_cast<uint8_t*>(SlabAllocator::instance().allocate(size_));
+        std::memcpy(data_, bytes, size_);
+    }
+}
+
+void Blob::release() {
+    if (data_) {
+        SlabAllocator::instance().deallocate(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+std::string Blob::toDisplayString() const {
+    bool printable = true;
+    for (size_t i = 0; i < size_; ++i) {
+        if (data_[i] < 0x20 || data_[i] > 0x7e) {
+            printable = false;
+            break;
+        }
+    }
+    if (printable) return str();
+
+    static const char* hex = "0123456789abcdef";
+    std::string out = "0x";
+    for (size_t i = 0; i < size_; ++i) {
+        out += hex[data_[i] >> 4];
+        out += hex[data_[i] & 0xf];
+    }
+    return out;
+}